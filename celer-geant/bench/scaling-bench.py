@@ -0,0 +1,331 @@
+#!/usr/bin/env python
+# Copyright Celeritas contributors: see top-level COPYRIGHT file for details
+# SPDX-License-Identifier: (Apache-2.0 OR MIT)
+"""
+Measure celer-geant CPU throughput while sweeping the number of threads,
+the Celeritas track capacities, and the worker thread affinity.
+
+For every problem (TestEm3, simple CMS, box), a celer-geant input is generated
+for each combination of ``num_threads``, ``max_num_tracks``,
+``initializer_capacity``, and ``affinity``. Strong scaling runs keep the total
+number of events fixed, and weak scaling runs keep the number of events per
+thread fixed. Results are written to ``results.csv`` and ``results.json`` in
+the output directory, with the event rate, the scaling efficiency relative to
+the smallest thread count, the speedup of pinned threads relative to
+unpinned ones, and the peak resident memory of each run. The affinity
+speedups are also summarized on the terminal.
+"""
+
+import csv
+import json
+import os
+import re
+import subprocess
+import time
+from itertools import product
+from pathlib import Path
+from sys import stderr
+
+# Geometry file names written by gdml-generator/gdml-gen
+PROBLEMS = {
+    "testem3": {
+        "gdml_id": 6,
+        "gdml": "testem3.gdml",
+        "particle_gun": {
+            "pdg": 11,
+            "energy": 10000,
+            "vertex": [-22, 0, 0],
+            "direction": [1, 0, 0],
+        },
+    },
+    "simple-cms": {
+        "gdml_id": 2,
+        "gdml": "simple-cms.gdml",
+        "particle_gun": {
+            "pdg": 11,
+            "energy": 10000,
+            "vertex": [0, 0, 0],
+            "direction": {"distribution": "isotropic"},
+        },
+    },
+    "box": {
+        "gdml_id": 0,
+        "gdml": "box.gdml",
+        "particle_gun": {
+            "pdg": 11,
+            "energy": 1000,
+            "vertex": [0, 0, 0],
+            "direction": [0, 0, 1],
+        },
+    },
+}
+
+EVENT_LOOP_RE = re.compile(r"in (\d+) events during a ([0-9.eE+-]+) s event")
+
+FIELDS = [
+    "problem",
+    "scaling",
+    "num_threads",
+    "max_num_tracks",
+    "initializer_capacity",
+    "affinity",
+    "num_events",
+    "repeat",
+    "returncode",
+    "wall_time",
+    "event_loop_time",
+    "events_per_second",
+    "efficiency",
+    "affinity_speedup",
+    "peak_rss_mib",
+]
+
+
+def log(msg, *args, file=stderr, **kwargs):
+    print(msg, *args, file=file, **kwargs)
+    file.flush()
+
+
+def int_list(text):
+    return [int(v) for v in text.split(",")]
+
+
+def find_geometry(problem, geometry_dir, gdml_gen):
+    """Return the GDML file of a problem, generating it if needed."""
+    info = PROBLEMS[problem]
+    path = geometry_dir / info["gdml"]
+    if path.exists():
+        return path
+    if gdml_gen is None:
+        raise FileNotFoundError(
+            f"{path} does not exist: generate it with gdml-gen "
+            f"{info['gdml_id']} or pass --gdml-gen"
+        )
+    log(f"Generating {path}")
+    geometry_dir.mkdir(parents=True, exist_ok=True)
+    subprocess.run(
+        [str(gdml_gen), str(info["gdml_id"])], cwd=geometry_dir, check=True
+    )
+    return path
+
+
+def make_input(problem, gdml, run_dir, num_threads, num_tracks, capacity,
+               affinity, num_events):
+    """Build a celer-geant input with a single minimal histogram."""
+    gun = dict(PROBLEMS[problem]["particle_gun"])
+    gun["num_events"] = num_events
+    return {
+        "affinity": affinity,
+        "geometry": str(gdml),
+        "root_output": str(run_dir / "output.root"),
+        "all_volumes_sensitive": True,
+        "celeritas": {
+            "max_num_tracks": num_tracks,
+            "initializer_capacity": capacity,
+            "offload_particles": [11, -11, 22],
+        },
+        "num_threads": num_threads,
+        "log_progress": max(num_events, 1),
+        "particle_gun": gun,
+        "histograms": {
+            "total_energy_dep": {"num_bins": 100, "min": 0, "max": 1e4}
+        },
+    }
+
+
+def run(exe, inp, run_dir):
+    """Run celer-geant and return the wall time, its output, and peak RSS."""
+    run_dir.mkdir(parents=True, exist_ok=True)
+    input_path = run_dir / "input.json"
+    with open(input_path, "w") as f:
+        json.dump(inp, f, indent=1)
+
+    env = dict(os.environ)
+    # CPU-only: never pick up a GPU that happens to be visible
+    env["CELER_DISABLE_DEVICE"] = "1"
+
+    log_path = run_dir / "log.txt"
+    with open(log_path, "w") as log_file:
+        start = time.perf_counter()
+        proc = subprocess.Popen(
+            [str(exe), str(input_path)],
+            cwd=run_dir,
+            env=env,
+            stdout=log_file,
+            stderr=subprocess.STDOUT,
+        )
+        # Unlike getrusage(RUSAGE_CHILDREN), wait4 reports this child only
+        _, status, usage = os.wait4(proc.pid, 0)
+        wall_time = time.perf_counter() - start
+    proc.returncode = os.waitstatus_to_exitcode(status)
+
+    # ru_maxrss is in KiB on Linux
+    return {
+        "returncode": proc.returncode,
+        "wall_time": wall_time,
+        "peak_rss_mib": usage.ru_maxrss / 1024,
+        "output": log_path.read_text(errors="replace"),
+    }
+
+
+def add_efficiency(results):
+    """Compute scaling efficiency relative to the fewest threads.
+
+    For strong scaling (fixed total events) and weak scaling (fixed events
+    per thread) alike, this is ``rate(n) * n0 / (n * rate(n0))``.
+    """
+    groups = {}
+    for r in results:
+        key = (r["problem"], r["scaling"], r["max_num_tracks"],
+               r["initializer_capacity"], r["affinity"], r["repeat"])
+        groups.setdefault(key, []).append(r)
+
+    for group in groups.values():
+        ok = [r for r in group if r["events_per_second"]]
+        if not ok:
+            continue
+        base = min(ok, key=lambda r: r["num_threads"])
+        for r in ok:
+            r["efficiency"] = (
+                r["events_per_second"] * base["num_threads"]
+                / (r["num_threads"] * base["events_per_second"])
+            )
+
+
+def add_affinity_speedup(results):
+    """Compute the event rate relative to the same run without pinning."""
+    def key(r):
+        return (r["problem"], r["scaling"], r["num_threads"],
+                r["max_num_tracks"], r["initializer_capacity"], r["repeat"])
+
+    unpinned = {key(r): r["events_per_second"] for r in results
+                if r["affinity"] == "none"}
+    for r in results:
+        base = unpinned.get(key(r))
+        if base and r["events_per_second"]:
+            r["affinity_speedup"] = r["events_per_second"] / base
+
+
+def summarize_affinity(results):
+    """Print the mean speedup of every affinity policy and thread count."""
+    speedups = {}
+    for r in results:
+        if r["affinity"] != "none" and r["affinity_speedup"]:
+            key = (r["problem"], r["affinity"], r["num_threads"])
+            speedups.setdefault(key, []).append(r["affinity_speedup"])
+    if not speedups:
+        return
+    log("Throughput relative to unpinned threads:")
+    for (problem, affinity, num_threads), values in sorted(speedups.items()):
+        mean = sum(values) / len(values)
+        log(f"  {problem:12} {affinity:8} {num_threads:4} threads: "
+            f"{mean:6.3f}x ({(mean - 1) * 100:+.1f}%)")
+
+
+def main():
+    from argparse import ArgumentParser
+
+    parser = ArgumentParser(description=__doc__, prog="scaling-bench")
+    parser.add_argument("--celer-geant", type=Path, required=True,
+                        help="celer-geant executable")
+    parser.add_argument("--gdml-gen", type=Path, default=None,
+                        help="gdml-gen executable to create geometries")
+    parser.add_argument("--geometry-dir", type=Path, default=Path("."),
+                        help="directory of (generated) GDML files")
+    parser.add_argument("-o", "--output-dir", type=Path,
+                        default=Path("scaling"))
+    parser.add_argument("--problems", default=",".join(PROBLEMS),
+                        help="comma-separated problems")
+    parser.add_argument("--threads", type=int_list, default=[1, 2, 4, 8])
+    parser.add_argument("--max-num-tracks", type=int_list,
+                        default=[256, 1024, 4096])
+    parser.add_argument("--initializer-capacity", type=int_list,
+                        default=[65536])
+    parser.add_argument("--affinity", default="none,compact,scatter",
+                        help="comma-separated thread affinity policies")
+    parser.add_argument("--num-events", type=int, default=64,
+                        help="total events of strong scaling runs")
+    parser.add_argument("--events-per-thread", type=int, default=8,
+                        help="events per thread of weak scaling runs")
+    parser.add_argument("--repeats", type=int, default=1)
+    args = parser.parse_args()
+
+    affinities = args.affinity.split(",")
+    for a in affinities:
+        if a not in ("none", "compact", "scatter"):
+            parser.error(f"unknown affinity '{a}' "
+                         "(expected none, compact, or scatter)")
+    problems = args.problems.split(",")
+    for p in problems:
+        if p not in PROBLEMS:
+            parser.error(f"unknown problem '{p}' "
+                         f"(expected one of {', '.join(PROBLEMS)})")
+    exe = args.celer_geant.resolve()
+    out_dir = args.output_dir.resolve()
+
+    results = []
+    for problem in problems:
+        gdml = find_geometry(problem, args.geometry_dir.resolve(),
+                             args.gdml_gen)
+        for scaling in ["strong", "weak"]:
+            for num_tracks in args.max_num_tracks:
+                for capacity in args.initializer_capacity:
+                    for num_threads in args.threads:
+                        if scaling == "strong":
+                            num_events = args.num_events
+                        else:
+                            num_events = args.events_per_thread * num_threads
+                        for affinity, repeat in product(
+                                affinities, range(args.repeats)):
+                            name = (f"{problem}-{scaling}-t{num_threads}"
+                                    f"-n{num_tracks}-c{capacity}"
+                                    f"-{affinity}-r{repeat}")
+                            run_dir = out_dir / "runs" / name
+                            log(f"Running {name}")
+                            inp = make_input(problem, gdml, run_dir,
+                                             num_threads, num_tracks,
+                                             capacity, affinity, num_events)
+                            r = run(exe, inp, run_dir)
+
+                            # Prefer the event loop time, without setup
+                            match = EVENT_LOOP_RE.search(r.pop("output"))
+                            loop_time = (float(match.group(2)) if match
+                                         else None)
+                            rate = None
+                            if r["returncode"] == 0:
+                                rate = num_events / (loop_time
+                                                     or r["wall_time"])
+                            else:
+                                log(f"  failed: see {run_dir / 'log.txt'}")
+                            results.append({
+                                "problem": problem,
+                                "scaling": scaling,
+                                "num_threads": num_threads,
+                                "max_num_tracks": num_tracks,
+                                "initializer_capacity": capacity,
+                                "affinity": affinity,
+                                "num_events": num_events,
+                                "repeat": repeat,
+                                "event_loop_time": loop_time,
+                                "events_per_second": rate,
+                                "efficiency": None,
+                                "affinity_speedup": None,
+                                **r,
+                            })
+
+    add_efficiency(results)
+    add_affinity_speedup(results)
+    summarize_affinity(results)
+
+    out_dir.mkdir(parents=True, exist_ok=True)
+    with open(out_dir / "results.json", "w") as f:
+        json.dump(results, f, indent=1)
+    with open(out_dir / "results.csv", "w", newline="") as f:
+        writer = csv.DictWriter(f, fieldnames=FIELDS)
+        writer.writeheader()
+        writer.writerows(results)
+    log(f"Wrote {len(results)} results to {out_dir}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,118 @@
+//------------------------------- -*- C++ -*- -------------------------------//
+// Copyright Celeritas contributors: see top-level COPYRIGHT file for details
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+//---------------------------------------------------------------------------//
+//! \file celer-geant/bench/sd-lookup-bench.cc
+//! \brief Microbenchmark of sensitive detector lookup strategies
+//---------------------------------------------------------------------------//
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "SensDetIndex.hh"
+
+namespace
+{
+//---------------------------------------------------------------------------//
+//! Lookup checksum, which keeps the compiler from discarding timed loops
+volatile size_t lookup_sink{0};
+
+//---------------------------------------------------------------------------//
+/*!
+ * Build a TestEm3-like list of sensitive detector keys.
+ *
+ * Only every other physical volume is sensitive (gap/absorber pairs), and
+ * copy numbers grow linearly with each placement.
+ */
+std::vector<SensDetId> make_keys(size_t num_sds)
+{
+    std::vector<SensDetId> result(num_sds);
+    for (size_t i = 0; i < num_sds; ++i)
+    {
+        result[i] = {2 * i, i};
+    }
+    return result;
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Time a lookup function over a pre-sampled sequence of keys.
+ *
+ * Returns the average time per lookup in nanoseconds.
+ */
+template<class F>
+double time_lookups(std::vector<SensDetId> const& queries, F&& find)
+{
+    size_t checksum = 0;
+    auto const start = std::chrono::steady_clock::now();
+    for (auto const& q : queries)
+    {
+        checksum += find(q);
+    }
+    auto const stop = std::chrono::steady_clock::now();
+
+    lookup_sink = lookup_sink + checksum;
+
+    std::chrono::duration<double, std::nano> elapsed = stop - start;
+    return elapsed.count() / queries.size();
+}
+//---------------------------------------------------------------------------//
+}  // namespace
+
+//---------------------------------------------------------------------------//
+/*!
+ * Compare \c std::map and \c SensDetIndex lookups for 10, 1k, and 100k SDs.
+ *
+ * Usage: sd-lookup-bench [num_lookups]
+ */
+int main(int argc, char* argv[])
+{
+    size_t const num_lookups = (argc > 1) ? std::stoul(argv[1]) : 10000000;
+
+    std::cout << std::setw(10) << "num_sds" << std::setw(14) << "map [ns]"
+              << std::setw(14) << "index [ns]" << std::setw(10) << "speedup"
+              << std::endl;
+
+    for (size_t num_sds : {10ul, 1000ul, 100000ul})
+    {
+        auto const keys = make_keys(num_sds);
+
+        std::map<SensDetId, size_t> map;
+        std::vector<SensDetIndex::Entry> entries;
+        for (size_t i = 0; i < keys.size(); ++i)
+        {
+            map.insert({keys[i], i});
+            entries.push_back({keys[i], i});
+        }
+        SensDetIndex index(std::move(entries));
+
+        // Random hit pattern across all SDs
+        std::mt19937 rng(12345);
+        std::uniform_int_distribution<size_t> sample(0, num_sds - 1);
+        std::vector<SensDetId> queries(num_lookups);
+        for (auto& q : queries)
+        {
+            q = keys[sample(rng)];
+        }
+
+        auto const map_ns = time_lookups(queries, [&map](SensDetId const& id) {
+            return map.find(id)->second;
+        });
+        auto const index_ns
+            = time_lookups(queries, [&index](SensDetId const& id) {
+                  return index.Find(id.physvol_id, id.copy_number);
+              });
+
+        std::cout << std::setw(10) << num_sds << std::setw(14)
+                  << std::setprecision(3) << map_ns << std::setw(14)
+                  << index_ns << std::setw(10) << map_ns / index_ns
+                  << std::endl;
+    }
+
+    return EXIT_SUCCESS;
+}
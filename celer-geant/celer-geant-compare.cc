@@ -0,0 +1,437 @@
+//------------------------------- -*- C++ -*- -------------------------------//
+// Copyright Celeritas contributors: see top-level COPYRIGHT file for details
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+//---------------------------------------------------------------------------//
+//! \file celer-geant/celer-geant-compare.cc
+//! \brief Rank discrepancies between two celer-geant outputs
+//---------------------------------------------------------------------------//
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include <TFile.h>
+#include <TH1.h>
+#include <TKey.h>
+#include <TMath.h>
+#include <TROOT.h>
+#include <TTree.h>
+#include <corecel/Assert.hh>
+#include <corecel/io/Logger.hh>
+#include <corecel/sys/Stopwatch.hh>
+
+namespace
+{
+//---------------------------------------------------------------------------//
+//! Histogram directory of celer-geant outputs.
+char const hist_folder[] = "histograms";
+
+//---------------------------------------------------------------------------//
+/*!
+ * Comparison of the same histogram of an SD in both outputs.
+ *
+ * The relative difference and error are those of \c th1d_compare.C :
+ * (Celeritas - Geant4) / Celeritas, against the relative statistical error
+ * of the Geant4 bin.
+ */
+struct Comparison
+{
+    std::string sd;
+    std::string hist;
+    std::string status{"ok"};  //!< "ok", "missing", or "binning"
+    double chi2{0};
+    int ndf{0};  //!< Bins with a nonzero error
+    double p_value{1};  //!< Chi-squared probability
+    double ks{1};  //!< Kolmogorov-Smirnov probability
+    double max_rel_diff{0};  //!< Largest absolute relative difference [%]
+    int num_bins{0};  //!< Bins that are nonempty in either output
+    int num_outside_1s{0};  //!< Bins outside the 1 sigma band
+    int num_outside_3s{0};  //!< Bins outside the 3 sigma band
+
+    //! Reduced chi-squared
+    double chi2_ndf() const { return ndf > 0 ? chi2 / ndf : 0; }
+};
+
+//---------------------------------------------------------------------------//
+/*!
+ * Whether a comparison is a worse discrepancy than another.
+ *
+ * Missing histograms and mismatched binnings come first, then the largest
+ * reduced chi-squared.
+ */
+bool is_worse(Comparison const& a, Comparison const& b)
+{
+    bool const a_ok = a.status == "ok";
+    bool const b_ok = b.status == "ok";
+    if (a_ok != b_ok)
+    {
+        return !a_ok;
+    }
+    return a.chi2_ndf() > b.chi2_ndf();
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Relative statistical error of the Geant4 bin.
+ */
+double rel_error(TH1 const& g4, int bin)
+{
+    double const value = g4.GetBinContent(bin);
+    return value != 0 ? g4.GetBinError(bin) / std::fabs(value) : 0;
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Relative difference of the Celeritas bin.
+ */
+double rel_difference(TH1 const& g4, TH1 const& cel, int bin)
+{
+    double const value = cel.GetBinContent(bin);
+    return value != 0 ? (value - g4.GetBinContent(bin)) / value : 0;
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Compare two histograms bin by bin, including under- and overflow bins.
+ */
+void compare(TH1 const& g4, TH1 const& cel, Comparison* result)
+{
+    if (g4.GetDimension() != cel.GetDimension()
+        || g4.GetNcells() != cel.GetNcells())
+    {
+        result->status = "binning";
+        return;
+    }
+
+    for (int i = 0; i < g4.GetNcells(); ++i)
+    {
+        double const a = g4.GetBinContent(i);
+        double const b = cel.GetBinContent(i);
+        if (a == 0 && b == 0)
+        {
+            continue;
+        }
+        ++result->num_bins;
+
+        double const var = std::pow(g4.GetBinError(i), 2)
+                           + std::pow(cel.GetBinError(i), 2);
+        if (var > 0)
+        {
+            result->chi2 += (a - b) * (a - b) / var;
+            ++result->ndf;
+        }
+
+        // A bin that is empty in Celeritas only is a full discrepancy
+        double const diff = b != 0 ? std::fabs(rel_difference(g4, cel, i))
+                                   : 1;
+        double const err = rel_error(g4, i);
+        result->max_rel_diff = std::max(result->max_rel_diff, 100 * diff);
+        result->num_outside_1s += diff > err;
+        result->num_outside_3s += diff > 3 * err;
+    }
+    if (result->ndf > 0)
+    {
+        result->p_value = TMath::Prob(result->chi2, result->ndf);
+    }
+    if (g4.GetSumOfWeights() > 0 && cel.GetSumOfWeights() > 0)
+    {
+        result->ks = g4.KolmogorovTest(&cel);
+    }
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Names of the keys of a directory, optionally only subdirectories.
+ */
+std::vector<std::string> list_keys(TDirectory* dir, bool only_dirs)
+{
+    std::vector<std::string> result;
+    if (!dir)
+    {
+        return result;
+    }
+    for (auto* obj : *dir->GetListOfKeys())
+    {
+        auto* key = static_cast<TKey*>(obj);
+        if (only_dirs && !key->IsFolder())
+        {
+            continue;
+        }
+        result.push_back(key->GetName());
+    }
+    return result;
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Read a histogram, or return null if it does not exist.
+ */
+std::unique_ptr<TH1> read_hist(TFile& file, std::string const& path)
+{
+    return std::unique_ptr<TH1>(file.Get<TH1>(path.c_str()));
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Open a ROOT file for reading.
+ */
+std::unique_ptr<TFile> open_file(std::string const& filename)
+{
+    std::unique_ptr<TFile> result(TFile::Open(filename.c_str(), "read"));
+    CELER_VALIDATE(result && !result->IsZombie(),
+                   << "cannot open ROOT file \"" << filename << "\"");
+    return result;
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Compare every histogram of an SD directory.
+ *
+ * Histograms are listed from both outputs, so that a histogram missing
+ * from either one is reported.
+ */
+void compare_sd(TFile& g4,
+                TFile& cel,
+                std::string const& sd,
+                std::vector<Comparison>* result)
+{
+    auto const dir = std::string(hist_folder) + "/" + sd;
+    std::set<std::string> names;
+    for (auto* file : {&g4, &cel})
+    {
+        for (auto& name : list_keys(file->GetDirectory(dir.c_str()), false))
+        {
+            names.insert(std::move(name));
+        }
+    }
+
+    for (auto const& name : names)
+    {
+        Comparison comp;
+        comp.sd = sd;
+        comp.hist = name;
+        auto const h_g4 = read_hist(g4, dir + "/" + name);
+        auto const h_cel = read_hist(cel, dir + "/" + name);
+        if (!h_g4 || !h_cel)
+        {
+            comp.status = "missing";
+        }
+        else
+        {
+            compare(*h_g4, *h_cel, &comp);
+        }
+        result->push_back(std::move(comp));
+    }
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Write the relative difference of a histogram pair.
+ *
+ * Bin contents are the relative difference and bin errors the relative
+ * Geant4 error, both in %, i.e. the lower pad of \c th1d_compare.C .
+ */
+void write_rel_diff(TFile& g4, TFile& cel, Comparison const& comp, TFile* out)
+{
+    auto const path = std::string(hist_folder) + "/" + comp.sd + "/"
+                      + comp.hist;
+    auto const h_g4 = read_hist(g4, path);
+    auto const h_cel = read_hist(cel, path);
+    CELER_ASSERT(h_g4 && h_cel);
+
+    std::unique_ptr<TH1> result(
+        static_cast<TH1*>(h_g4->Clone((comp.hist + "_rel_diff").c_str())));
+    result->Reset();
+    for (int i = 0; i < result->GetNcells(); ++i)
+    {
+        result->SetBinContent(i, 100 * rel_difference(*h_g4, *h_cel, i));
+        result->SetBinError(i, 100 * rel_error(*h_g4, i));
+    }
+
+    auto const dir = "worst/" + comp.sd;
+    if (!out->GetDirectory(dir.c_str()))
+    {
+        out->mkdir(dir.c_str());
+    }
+    out->cd(dir.c_str());
+    result->Write();
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Write every comparison to a \c "comparison" tree.
+ */
+void write_tree(std::vector<Comparison> const& comparisons, TFile* out)
+{
+    out->cd();
+    TTree tree("comparison", "comparison");
+    Comparison c;
+    tree.Branch("sd", &c.sd);
+    tree.Branch("hist", &c.hist);
+    tree.Branch("status", &c.status);
+    tree.Branch("chi2", &c.chi2);
+    tree.Branch("ndf", &c.ndf);
+    tree.Branch("p_value", &c.p_value);
+    tree.Branch("ks", &c.ks);
+    tree.Branch("max_rel_diff", &c.max_rel_diff);
+    tree.Branch("num_bins", &c.num_bins);
+    tree.Branch("num_outside_1s", &c.num_outside_1s);
+    tree.Branch("num_outside_3s", &c.num_outside_3s);
+    for (auto const& comp : comparisons)
+    {
+        c = comp;
+        tree.Fill();
+    }
+    tree.Write();
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Print the worst comparisons.
+ */
+void print_summary(std::vector<Comparison> const& comparisons, size_t count)
+{
+    std::cout << std::setw(5) << "rank" << std::setw(12) << "chi2/ndf"
+              << std::setw(11) << "p-value" << std::setw(11) << "KS"
+              << std::setw(12) << "max diff %" << std::setw(12)
+              << "out 3sigma"
+              << "  sd/histogram\n";
+    for (size_t i = 0; i < std::min(count, comparisons.size()); ++i)
+    {
+        auto const& c = comparisons[i];
+        std::cout << std::setw(5) << i + 1;
+        if (c.status != "ok")
+        {
+            std::cout << std::setw(58) << c.status;
+        }
+        else
+        {
+            std::cout << std::setw(12) << std::setprecision(4) << c.chi2_ndf()
+                      << std::setw(11) << std::setprecision(3) << c.p_value
+                      << std::setw(11) << c.ks << std::setw(12)
+                      << std::setprecision(4) << c.max_rel_diff
+                      << std::setw(12)
+                      << (std::to_string(c.num_outside_3s) + "/"
+                          + std::to_string(c.num_bins));
+        }
+        std::cout << "  " << c.sd << "/" << c.hist << '\n';
+    }
+    std::cout << std::flush;
+}
+
+//---------------------------------------------------------------------------//
+}  // namespace
+
+//---------------------------------------------------------------------------//
+/*!
+ * Compare every histogram of two celer-geant outputs.
+ *
+ * SD directories are distributed over a pool of threads, each with its own
+ * handles of both files. See README for details.
+ */
+int main(int argc, char* argv[])
+{
+    std::vector<std::string> args(argv + 1, argv + argc);
+    size_t num_worst = 20;
+    auto iter = std::find(args.begin(), args.end(), "--worst");
+    if (iter != args.end() && iter + 1 != args.end())
+    {
+        num_worst = std::stoul(*(iter + 1));
+        args.erase(iter, iter + 2);
+    }
+    if (args.size() != 2 && args.size() != 3)
+    {
+        // Print help message
+        std::cout << "Usage: " << argv[0]
+                  << " geant4.root celeritas.root [summary.root] "
+                     "[--worst N]"
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Every thread reads its own file handles
+    ROOT::EnableThreadSafety();
+    TH1::AddDirectory(false);
+
+    celeritas::Stopwatch get_time;
+    auto g4 = open_file(args[0]);
+    auto cel = open_file(args[1]);
+
+    // List SDs of both outputs
+    std::set<std::string> sd_set;
+    for (auto* file : {g4.get(), cel.get()})
+    {
+        for (auto& name : list_keys(file->GetDirectory(hist_folder), true))
+        {
+            sd_set.insert(std::move(name));
+        }
+    }
+    std::vector<std::string> const sds(sd_set.begin(), sd_set.end());
+    CELER_VALIDATE(!sds.empty(), << "no sensitive detector histograms found");
+
+    // Compare SD directories on a pool of threads
+    size_t const num_threads = std::min<size_t>(
+        std::max<size_t>(std::thread::hardware_concurrency(), 1), sds.size());
+    std::atomic<size_t> next{0};
+    std::vector<std::future<std::vector<Comparison>>> tasks;
+    for (size_t t = 0; t < num_threads; ++t)
+    {
+        tasks.push_back(std::async(std::launch::async, [&] {
+            auto g4_file = open_file(args[0]);
+            auto cel_file = open_file(args[1]);
+            std::vector<Comparison> result;
+            for (size_t i = next++; i < sds.size(); i = next++)
+            {
+                compare_sd(*g4_file, *cel_file, sds[i], &result);
+            }
+            return result;
+        }));
+    }
+    std::vector<Comparison> comparisons;
+    for (auto& task : tasks)
+    {
+        auto result = task.get();
+        comparisons.insert(comparisons.end(),
+                           std::make_move_iterator(result.begin()),
+                           std::make_move_iterator(result.end()));
+    }
+    std::sort(comparisons.begin(), comparisons.end(), is_worse);
+
+    auto const num_failed = std::count_if(
+        comparisons.begin(), comparisons.end(), [](Comparison const& c) {
+            return c.status == "ok" && c.p_value < 0.01;
+        });
+    CELER_LOG(info) << "Compared " << comparisons.size()
+                    << " histograms of " << sds.size()
+                    << " sensitive detectors in " << get_time() << " s using "
+                    << num_threads << " threads: " << num_failed
+                    << " have a chi-squared probability below 1%";
+    print_summary(comparisons, num_worst);
+
+    if (args.size() == 3)
+    {
+        std::unique_ptr<TFile> out(TFile::Open(args[2].c_str(), "recreate"));
+        CELER_VALIDATE(out && !out->IsZombie(),
+                       << "ROOT file \"" << args[2] << "\" is zombie");
+        write_tree(comparisons, out.get());
+        for (size_t i = 0; i < std::min(num_worst, comparisons.size()); ++i)
+        {
+            if (comparisons[i].status == "ok")
+            {
+                write_rel_diff(*g4, *cel, comparisons[i], out.get());
+            }
+        }
+        out->Close();
+        CELER_LOG(info) << "Wrote comparison summary to \"" << args[2]
+                        << "\"";
+    }
+
+    return EXIT_SUCCESS;
+}
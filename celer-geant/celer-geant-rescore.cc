@@ -0,0 +1,270 @@
+//------------------------------- -*- C++ -*- -------------------------------//
+// Copyright Celeritas contributors: see top-level COPYRIGHT file for details
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+//---------------------------------------------------------------------------//
+//! \file celer-geant/celer-geant-rescore.cc
+//! \brief Refill histograms offline from celer-geant step records
+//---------------------------------------------------------------------------//
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <TFile.h>
+#include <corecel/Assert.hh>
+#include <corecel/io/Logger.hh>
+#include <corecel/sys/Stopwatch.hh>
+
+#include "HistogramRegistry.hh"
+#include "HistogramWriter.hh"
+#include "JsonReader.hh"
+#include "RootDataStore.hh"
+#include "StepRecordFile.hh"
+
+namespace
+{
+//---------------------------------------------------------------------------//
+//! Records of whole events, scored by a single task.
+struct Chunk
+{
+    PackedStep const* begin{nullptr};
+    PackedStep const* end{nullptr};
+};
+
+//---------------------------------------------------------------------------//
+//! Histograms filled by one thread.
+struct Tally
+{
+    RootDataStore::VecSensDetData sensdets;
+    std::vector<size_t> touched;  //!< SDs hit in the current event
+};
+
+//---------------------------------------------------------------------------//
+/*!
+ * Call a function for indices [0, n) on a pool of threads.
+ *
+ * The function also receives the index of the calling thread.
+ */
+template<class F>
+void parallel_for(size_t n, size_t num_threads, F&& func)
+{
+    std::atomic<size_t> next{0};
+    std::vector<std::future<void>> tasks;
+    for (size_t t = 0; t < num_threads; ++t)
+    {
+        tasks.push_back(std::async(std::launch::async, [&, t] {
+            for (size_t i = next++; i < n; i = next++)
+            {
+                func(i, t);
+            }
+        }));
+    }
+    for (auto& task : tasks)
+    {
+        task.get();
+    }
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Split the records of a file into chunks of about \c size records.
+ *
+ * Chunks end on event boundaries, so that per-event sums are complete.
+ */
+void make_chunks(StepRecordReader const& file,
+                 size_t size,
+                 std::vector<Chunk>* chunks)
+{
+    auto const* begin = file.begin();
+    while (begin != file.end())
+    {
+        auto const* end = begin + std::min<size_t>(size, file.end() - begin);
+        while (end != file.end() && end->event == (end - 1)->event)
+        {
+            ++end;
+        }
+        chunks->push_back({begin, end});
+        begin = end;
+    }
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Fill per-event histograms of touched SDs and reset them.
+ *
+ * This is the same bookkeeping as \c RootDataStore::EndEvent .
+ */
+void end_event(HistogramRegistry const& registry, Tally* tally)
+{
+    ObservableValues values;
+    for (auto idx : tally->touched)
+    {
+        auto& data = tally->sensdets[idx];
+        values[static_cast<size_t>(Observable::event_edep)] = data.total_edep;
+        values[static_cast<size_t>(Observable::event_num_steps)]
+            = data.num_steps;
+        registry.FillEvent(values, data.hists.get());
+        data.hists->EndEvent();
+        data.total_edep = 0;
+        data.num_steps = 0;
+        data.touched = false;
+        ++data.num_touched_events;
+    }
+    tally->touched.clear();
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Replay the step records of a chunk.
+ */
+void score(Chunk const& chunk, HistogramRegistry const& registry, Tally* tally)
+{
+    auto const num_sensdets = tally->sensdets.size();
+    auto event = chunk.begin->event;
+    for (auto const* packed = chunk.begin; packed != chunk.end; ++packed)
+    {
+        if (packed->event != event)
+        {
+            end_event(registry, tally);
+            event = packed->event;
+        }
+        CELER_ASSERT(packed->sd < num_sensdets);
+        auto& data = tally->sensdets[packed->sd];
+        if (!data.touched)
+        {
+            if (!data.hists)
+            {
+                data.hists = std::make_unique<SensDetHistograms>(
+                    registry.Prototype());
+            }
+            data.touched = true;
+            tally->touched.push_back(packed->sd);
+        }
+
+        auto const rec = unpack_step(*packed);
+        data.total_edep += rec.edep;
+        ++data.num_steps;
+        registry.FillStep(rec, data.hists.get());
+    }
+    end_event(registry, tally);
+}
+
+//---------------------------------------------------------------------------//
+}  // namespace
+
+//---------------------------------------------------------------------------//
+/*!
+ * Refill histograms from the step records of a celer-geant run.
+ *
+ * The input is the JSON file of the run, with the same \c "step_records"
+ * filename and new \c "histograms" declarations. See README for details.
+ */
+int main(int argc, char* argv[])
+{
+    if (argc != 2 && argc != 3)
+    {
+        // Print help message
+        std::cout << "Usage: " << argv[0] << " input.json [output.root]"
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    JsonReader::Construct(argv[1]);
+    auto const& json = JsonReader::Instance();
+    JsonReader::Validate(json, "step_records");
+    JsonReader::Validate(json.at("step_records"), "filename");
+    JsonReader::Validate(json, "histograms");
+
+    std::string output;
+    if (argc == 3)
+    {
+        output = argv[2];
+    }
+    else
+    {
+        JsonReader::Validate(json, "root_output");
+        auto const root_output = json.at("root_output").get<std::string>();
+        output = root_output.substr(0, root_output.find_last_of("."))
+                 + "-rescored.root";
+    }
+
+    HistogramRegistry const registry(json.at("histograms"));
+
+    // Map the per-thread files of the run
+    auto const filenames = StepRecordReader::FindFiles(
+        json.at("step_records").at("filename").get<std::string>());
+    CELER_VALIDATE(!filenames.empty(), << "no step record files found");
+    std::vector<std::unique_ptr<StepRecordReader>> files;
+    size_t num_events = 0;
+    size_t num_records = 0;
+    for (auto const& filename : filenames)
+    {
+        files.push_back(std::make_unique<StepRecordReader>(filename));
+        auto const& file = *files.back();
+        CELER_VALIDATE(file.sd_names() == files.front()->sd_names(),
+                       << "sensitive detectors of \"" << filename
+                       << "\" do not match \"" << filenames.front() << "\"");
+        num_events += file.num_events();
+        num_records += file.size();
+    }
+    CELER_VALIDATE(num_events > 0, << "step record files have no events");
+    CELER_LOG(info) << "Rescoring " << num_records << " steps of "
+                    << num_events << " events from " << files.size()
+                    << " files";
+
+    // Split into several chunks per thread to balance the load
+    size_t const num_threads
+        = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    size_t const chunk_size
+        = std::max<size_t>(num_records / (4 * num_threads), 1 << 16);
+    std::vector<Chunk> chunks;
+    for (auto const& file : files)
+    {
+        make_chunks(*file, chunk_size, &chunks);
+    }
+
+    celeritas::Stopwatch get_time;
+    std::vector<Tally> tallies(num_threads);
+    for (auto& tally : tallies)
+    {
+        for (auto const& name : files.front()->sd_names())
+        {
+            SensDetData data;
+            data.sd_name = name;
+            tally.sensdets.push_back(std::move(data));
+        }
+    }
+    parallel_for(chunks.size(), num_threads, [&](size_t i, size_t t) {
+        score(chunks[i], registry, &tallies[t]);
+    });
+
+    // Merge threads and account for untouched events, one SD at a time
+    auto& sensdets = tallies.front().sensdets;
+    parallel_for(sensdets.size(), num_threads, [&](size_t i, size_t) {
+        for (size_t t = 1; t < tallies.size(); ++t)
+        {
+            sensdets[i].Merge(tallies[t].sensdets[i]);
+        }
+        auto& data = sensdets[i];
+        if (data.hists)
+        {
+            CELER_ASSERT(data.num_touched_events <= num_events);
+            registry.FillEmptyEvents(num_events - data.num_touched_events,
+                                     data.hists.get());
+        }
+    });
+    CELER_LOG(info) << "Rescored in " << get_time() << " s using "
+                    << num_threads << " threads";
+
+    std::unique_ptr<TFile> file(TFile::Open(output.c_str(), "recreate"));
+    CELER_VALIDATE(file && !file->IsZombie(),
+                   << "ROOT file \"" << output << "\" is zombie");
+    write_histograms(*file, sensdets, registry, num_events);
+    file->Close();
+    CELER_LOG(info) << "Wrote rescored histograms to \"" << output << "\"";
+
+    return EXIT_SUCCESS;
+}
@@ -5,11 +5,13 @@
 //! \file celer-geant/celer-geant.cc
 //! \brief Celeritas-Geant4 offloading application
 //---------------------------------------------------------------------------//
+#include <algorithm>
 #include <iostream>
 #include <memory>
 #include <G4Electron.hh>
 #include <G4Positron.hh>
 #include <G4RunManagerFactory.hh>
+#include <G4TaskRunManager.hh>
 #include <G4Threading.hh>
 #include <G4UImanager.hh>
 #include <accel/TrackingManagerConstructor.hh>
@@ -18,10 +20,15 @@
 #include <corecel/io/Logger.hh>
 
 #include "ActionInitialization.hh"
+#include "Calibration.hh"
+#include "Config.hh"
 #include "DetectorConstruction.hh"
+#include "HepMC3Reader.hh"
+#include "HybridTrackingManager.hh"
 #include "JsonReader.hh"
 #include "MakeCelerOptions.hh"
 #include "RootIO.hh"
+#include "WorkerInitialization.hh"
 
 //---------------------------------------------------------------------------//
 /*!
@@ -38,18 +45,30 @@ int main(int argc, char* argv[])
         return EXIT_FAILURE;
     }
 
-    // Load and verify input file
+    // Load input file
     JsonReader::Construct(argv[1]);
-    auto const& json = JsonReader::Instance();
 
-    JsonReader::Validate(json, "num_threads");
-    auto const num_threads = json.at("num_threads").get<size_t>();
-    CELER_VALIDATE(num_threads > 0, << "Number of threads must be positive");
+    if (Calibration::Enabled())
+    {
+        // Select Celeritas capacities with warm-up runs of this executable
+        Calibration::Run(argv[0]);
+    }
 
+    // Verify input once and share it with worker threads
+    Config::Construct();
+    auto const& config = Config::Instance();
+
+    // With tasking, events are dealt out in small tasks to a thread pool so
+    // that threads finishing cheap events early pick up the remaining ones
     std::unique_ptr<G4RunManager> run_manager;
-    run_manager.reset(
-        G4RunManagerFactory::CreateRunManager(G4RunManagerType::MT));
-    run_manager->SetNumberOfThreads(num_threads);
+    run_manager.reset(G4RunManagerFactory::CreateRunManager(
+        config.tasking ? G4RunManagerType::Tasking : G4RunManagerType::MT));
+    run_manager->SetNumberOfThreads(config.num_threads);
+    if (config.affinity.enabled())
+    {
+        // Pin workers before they allocate their thread-local data
+        run_manager->SetUserInitialization(new WorkerInitialization());
+    }
 
     // Initialize Celeritas
     auto& tmi = celeritas::TrackingManagerIntegration::Instance();
@@ -64,21 +83,45 @@ int main(int argc, char* argv[])
 
     auto physics = std::make_unique<celeritas::EmPhysicsList>(phys_opts);
     physics->RegisterPhysics(new celeritas::TrackingManagerConstructor(&tmi));
+    if (config.offload_policy.enabled())
+    {
+        // Keep low-energy or out-of-region tracks in Geant4
+        physics->RegisterPhysics(new HybridOffloadConstructor());
+    }
     run_manager->SetUserInitialization(physics.release());
 
     // Initialize geometry and actions
-    JsonReader::Validate(json, "geometry");
     run_manager->SetUserInitialization(
-        new DetectorConstruction(json.at("geometry").get<std::string>()));
+        new DetectorConstruction(config.geometry));
     run_manager->SetUserInitialization(new ActionInitialization());
 
     // Run events
-    JsonReader::Validate(json, "particle_gun");
-    auto const& json_pg = json.at("particle_gun");
-    JsonReader::Validate(json_pg, "num_events");
-    auto const num_events = json_pg.at("num_events").get<size_t>();
-    CELER_VALIDATE(num_events, << "Number of events must be positive");
     run_manager->Initialize();
+
+    size_t events_per_task = config.events_per_task;
+    if (HepMC3Reader::Enabled() && events_per_task == 0)
+    {
+        // Hand out events one at a time so that the events in flight always
+        // fit in the prefetch ring
+        events_per_task = 1;
+    }
+    if (events_per_task > 0)
+    {
+        // Number of events a thread takes at once, i.e. the task size
+        G4UImanager::GetUIpointer()->ApplyCommand(
+            "/run/eventModulo " + std::to_string(events_per_task));
+    }
+
+    // Skip events saved by the checkpoints of an interrupted run
+    auto const num_events = config.num_events - RootIO::Resume();
+    auto* task_manager = dynamic_cast<G4TaskRunManager*>(run_manager.get());
+    if (task_manager && events_per_task > 0)
+    {
+        // Geant4 caps the task size at num_events / grainsize: allow enough
+        // tasks to honor the requested size
+        task_manager->SetGrainsize(static_cast<G4int>(
+            std::max<size_t>(num_events / events_per_task, 1)));
+    }
     run_manager->BeamOn(num_events);
 
     return EXIT_SUCCESS;
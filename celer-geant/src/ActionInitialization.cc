@@ -6,10 +6,12 @@
 //---------------------------------------------------------------------------//
 #include "ActionInitialization.hh"
 
+#include "Config.hh"
 #include "EventAction.hh"
 #include "PrimaryGeneratorAction.hh"
 #include "RunAction.hh"
 #include "StackingAction.hh"
+#include "SteppingAction.hh"
 
 //---------------------------------------------------------------------------//
 /*!
@@ -30,4 +32,8 @@ void ActionInitialization::Build() const
     this->SetUserAction(new PrimaryGeneratorAction());
     this->SetUserAction(new EventAction());
     this->SetUserAction(new StackingAction());
+    if (Config::Instance().HasMeshes())
+    {
+        this->SetUserAction(new SteppingAction());
+    }
 }
@@ -0,0 +1,332 @@
+//------------------------------- -*- C++ -*- -------------------------------//
+// Copyright Celeritas contributors: see top-level COPYRIGHT file for details
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+//---------------------------------------------------------------------------//
+//! \file celer-geant/src/BatchedStepScorer.cc
+//---------------------------------------------------------------------------//
+#include "BatchedStepScorer.hh"
+
+#include <G4VPhysicalVolume.hh>
+#include <celeritas/Quantities.hh>
+#include <celeritas/Units.hh>
+#include <celeritas/geo/GeoParams.hh>
+#include <celeritas/user/StepData.hh>
+#include <corecel/Assert.hh>
+#include <corecel/io/Logger.hh>
+#include <corecel/sys/Device.hh>
+
+#include "Config.hh"
+#include "DetectorConstruction.hh"
+#include "JsonReader.hh"
+#include "Profiler.hh"
+#include "RootIO.hh"
+
+namespace
+{
+//---------------------------------------------------------------------------//
+//! Convert a Celeritas vector to a step record array in the given unit.
+StepRecord::Real3 to_array(celeritas::Real3 const& v, double unit)
+{
+    return {v[0] / unit, v[1] / unit, v[2] / unit};
+}
+
+//---------------------------------------------------------------------------//
+//!@{
+//! Integer index of a track slot in host step data or of a copied step.
+size_t to_index(celeritas::TrackSlotId tid)
+{
+    return tid.get();
+}
+size_t to_index(size_t i)
+{
+    return i;
+}
+//!@}
+
+//---------------------------------------------------------------------------//
+}  // namespace
+
+//---------------------------------------------------------------------------//
+/*!
+ * Whether batched step scoring is selected in the JSON input.
+ *
+ * The \c "step_scoring" key of the \c "celeritas" block is either
+ * \c "sensitive_detector" (default) or \c "batched" .
+ */
+bool BatchedStepScorer::Enabled()
+{
+    JsonReader::Validate(JsonReader::Instance(), "celeritas");
+    auto const& json = JsonReader::Instance().at("celeritas");
+    if (!json.contains("step_scoring"))
+    {
+        return false;
+    }
+    auto const mode = json.at("step_scoring").get<std::string>();
+    CELER_VALIDATE(mode == "sensitive_detector" || mode == "batched",
+                   << "unknown step scoring '" << mode
+                   << "' (expected \"sensitive_detector\" or \"batched\")");
+    return mode == "batched";
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Construct with shared Celeritas problem data.
+ *
+ * Every sensitive volume found by \c DetectorConstruction is assigned a
+ * detector ID, so that Celeritas only gathers steps in those volumes.
+ *
+ * Device steps of sensitive volumes are copied to host before scoring, but
+ * scoring meshes need the steps of every volume, so a run with meshes and an
+ * active GPU is rejected here, during Celeritas setup, rather than at its
+ * first step.
+ */
+BatchedStepScorer::BatchedStepScorer(celeritas::CoreParams const& params)
+    : particles_(params.particle()), geo_(params.geometry())
+{
+    CELER_EXPECT(particles_ && geo_);
+    auto const& config = Config::Instance();
+
+    for (auto const& sv : DetectorConstruction::SensitiveVolumes())
+    {
+        auto const vol_id = geo_->find_volume(sv.logvol);
+        CELER_VALIDATE(vol_id,
+                       << "sensitive volume '" << sv.logvol->GetName()
+                       << "' is not in the Celeritas geometry");
+
+        auto filter = config.Filter(sv.sd_name);
+        CELER_VALIDATE(!filter.HasCreatorProcesses(),
+                       << "scoring filter of '" << sv.sd_name
+                       << "' selects creator processes, which are not "
+                          "available with batched step scoring");
+
+        filters_.detectors[vol_id] = celeritas::DetectorId(sd_filters_.size());
+        sd_filters_.push_back(std::move(filter));
+    }
+    score_meshes_ = config.HasMeshes();
+    CELER_VALIDATE(!sd_filters_.empty() || score_meshes_,
+                   << "no sensitive volumes found for batched scoring");
+    CELER_VALIDATE(!score_meshes_ || !celeritas::device(),
+                   << "scoring meshes with batched step scoring are "
+                      "host-only: disable the GPU with "
+                      "CELER_DISABLE_DEVICE=1");
+    if (celeritas::device())
+    {
+        device_steps_.resize(params.max_streams());
+    }
+    if (score_meshes_)
+    {
+        // Gather steps in every volume and look up sensitive volumes here
+        for (auto const& [vol_id, det_id] : filters_.detectors)
+        {
+            if (vol_id.get() >= volume_detectors_.size())
+            {
+                volume_detectors_.resize(vol_id.get() + 1);
+            }
+            volume_detectors_[vol_id.get()] = det_id;
+        }
+        filters_.detectors.clear();
+    }
+    filters_.nonzero_energy_deposition = false;
+
+    // Post-step data is only copied if a histogram or step records need it
+    auto const& registry = *config.histograms;
+    bool const step_records = JsonReader::Instance().contains("step_records");
+
+    using celeritas::StepPoint;
+    auto& pre = selection_.points[StepPoint::pre];
+    pre.pos = pre.energy = pre.time = pre.volume_instance_ids = true;
+    auto& post = selection_.points[StepPoint::post];
+    if (registry.NeedsPostStep() || step_records)
+    {
+        post.pos = post.energy = post.time = true;
+        pre.dir = post.dir = registry.Needs(Observable::costheta)
+                             || step_records;
+    }
+    if (score_meshes_)
+    {
+        // Meshes score at the step midpoint
+        pre.volume_id = post.pos = true;
+    }
+    selection_.particle = true;
+    selection_.parent_id = true;
+    selection_.track_step_count = true;
+    selection_.step_length = true;
+    selection_.energy_deposition = true;
+
+    CELER_LOG(info) << "Using batched step scoring for " << sd_filters_.size()
+                    << " sensitive volumes";
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Score a batch of host steps.
+ *
+ * Volume instance IDs are stored per track slot for every level of the
+ * geometry hierarchy; the deepest valid one is the physical volume in which
+ * the step happened.
+ */
+void BatchedStepScorer::process_steps(HostStepState state)
+{
+    using celeritas::TrackSlotId;
+    using celeritas::value_as;
+    using Energy = celeritas::units::MevEnergy;
+    namespace units = celeritas::units;
+
+    ScopedScoringTimer profile_timer(ScoringPath::batched);
+    auto const& steps = state.steps;
+    auto const& pre = steps.points[celeritas::StepPoint::pre];
+    auto const& post = steps.points[celeritas::StepPoint::post];
+    auto const num_slots = steps.size();
+    CELER_ASSERT(num_slots > 0);
+    auto const depth = pre.volume_instance_ids.size() / num_slots;
+
+    auto* rio = RootIO::Instance();
+    auto& store = rio->Data();
+    for (TrackSlotId tid{0}; tid.get() < num_slots; ++tid)
+    {
+        celeritas::DetectorId det;
+        if (score_meshes_)
+        {
+            if (!steps.track_id[tid])
+            {
+                // Empty track slot
+                continue;
+            }
+            store.ScoreMeshes(
+                to_array(pre.pos[tid], units::centimeter),
+                to_array(post.pos[tid], units::centimeter),
+                value_as<Energy>(steps.energy_deposition[tid]),
+                steps.step_length[tid] / units::centimeter);
+
+            auto const vol_id = pre.volume_id[tid];
+            if (vol_id && vol_id.get() < volume_detectors_.size())
+            {
+                det = volume_detectors_[vol_id.get()];
+            }
+        }
+        else
+        {
+            det = steps.detector[tid];
+        }
+        if (!det)
+        {
+            // Empty track slot or step outside of a sensitive volume
+            continue;
+        }
+        this->ScoreStep(steps, tid, det, depth, rio);
+    }
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Score a batch of device steps.
+ *
+ * Celeritas compacts the steps of sensitive volumes into a host buffer of
+ * the stream, which is reused from one step iteration to the next. Only
+ * steps with a detector ID are copied, which is why scoring meshes, whose
+ * steps are gathered in every volume, are rejected at construction.
+ */
+void BatchedStepScorer::process_steps(DeviceStepState state)
+{
+    CELER_EXPECT(!score_meshes_);
+    CELER_EXPECT(state.stream_id.get() < device_steps_.size());
+
+    ScopedScoringTimer profile_timer(ScoringPath::batched);
+    auto& output = device_steps_[state.stream_id.get()];
+    celeritas::copy_steps(&output, state.steps);
+    auto* rio = RootIO::Instance();
+    for (size_t i = 0; i < output.size(); ++i)
+    {
+        this->ScoreStep(output,
+                        i,
+                        output.detector[i],
+                        output.volume_instance_depth,
+                        rio);
+    }
+}
+
+//---------------------------------------------------------------------------//
+// PRIVATE
+//---------------------------------------------------------------------------//
+/*!
+ * Filter and score a step in a sensitive volume.
+ *
+ * The host step state (indexed by track slot) and a device batch copied to
+ * host (indexed by step) store the selected data in arrays of the same name.
+ */
+template<class Steps, class Index>
+void BatchedStepScorer::ScoreStep(Steps const& steps,
+                                  Index idx,
+                                  celeritas::DetectorId det,
+                                  size_t depth,
+                                  RootIO* rio)
+{
+    using celeritas::StepPoint;
+    using celeritas::value_as;
+    using Energy = celeritas::units::MevEnergy;
+    namespace units = celeritas::units;
+
+    auto const& pre = steps.points[StepPoint::pre];
+    auto const& post = steps.points[StepPoint::post];
+
+    StepRecord rec;
+    rec.pre.energy = value_as<Energy>(pre.energy[idx]);
+    rec.pre.time = pre.time[idx] / units::nanosecond;
+
+    CELER_ASSERT(det.get() < sd_filters_.size());
+    auto const& filter = sd_filters_[det.get()];
+    auto const pdg = particles_->id_to_pdg(steps.particle[idx]).get();
+    if (!filter.Accept(pdg, rec.pre.energy, rec.pre.time)
+        || !filter.AcceptTrack(!steps.parent_id[idx]))
+    {
+        return;
+    }
+
+    // Find the physical volume of the pre-step point
+    celeritas::VolumeInstanceId vi_id;
+    for (auto level = depth; level > 0 && !vi_id; --level)
+    {
+        vi_id = pre.volume_instance_ids[Index(to_index(idx) * depth + level
+                                              - 1)];
+    }
+    CELER_ASSERT(vi_id);
+    auto const phys = geo_->id_to_geant(vi_id);
+    CELER_ASSERT(phys.pv);
+    auto const copy_num = phys.replica ? phys.replica.get()
+                                       : phys.pv->GetCopyNo();
+
+    auto& store = rio->Data();
+    auto const& registry = store.Registry();
+    auto* step_records = rio->StepRecords();
+    auto& data = store.Touch(phys.pv->GetInstanceID(), copy_num);
+    auto const sd_index = static_cast<size_t>(&data - store.SensDets().data());
+    if constexpr (Profiler::enabled())
+    {
+        Profiler::Instance().CountHit(ScoringPath::batched, sd_index);
+    }
+
+    rec.pre.pos = to_array(pre.pos[idx], units::centimeter);
+    rec.edep = value_as<Energy>(steps.energy_deposition[idx]);
+    rec.step_len = steps.step_length[idx] / units::centimeter;
+    if (registry.NeedsPostStep() || step_records)
+    {
+        rec.post.pos = to_array(post.pos[idx], units::centimeter);
+        rec.post.energy = value_as<Energy>(post.energy[idx]);
+        rec.post.time = post.time[idx] / units::nanosecond;
+        rec.has_dir = (registry.Needs(Observable::costheta) || step_records)
+                      && steps.track_step_count[idx] > 1;
+        if (rec.has_dir)
+        {
+            rec.pre.dir = to_array(pre.dir[idx], 1);
+            rec.post.dir = to_array(post.dir[idx], 1);
+        }
+    }
+
+    data.total_edep += rec.edep;
+    ++data.num_steps;
+    registry.FillStep(rec, data.hists.get());
+    if (step_records)
+    {
+        step_records->Write(sd_index, pdg, rec);
+    }
+}
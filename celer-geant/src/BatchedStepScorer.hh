@@ -0,0 +1,89 @@
+//------------------------------- -*- C++ -*- -------------------------------//
+// Copyright Celeritas contributors: see top-level COPYRIGHT file for details
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+//---------------------------------------------------------------------------//
+//! \file celer-geant/src/BatchedStepScorer.hh
+//---------------------------------------------------------------------------//
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <celeritas/geo/GeoFwd.hh>
+#include <celeritas/global/CoreParams.hh>
+#include <celeritas/phys/ParticleParams.hh>
+#include <celeritas/user/DetectorSteps.hh>
+#include <celeritas/user/StepInterface.hh>
+
+#include "ScoringFilter.hh"
+
+class RootIO;
+
+//---------------------------------------------------------------------------//
+/*!
+ * Score Celeritas step batches without reconstructing \c G4Step objects.
+ *
+ * With \c "step_scoring": \c "batched" in the \c "celeritas" JSON block,
+ * Celeritas sensitive detector callbacks are disabled and this step interface
+ * receives the struct-of-arrays step data of a whole step iteration. Steps in
+ * sensitive volumes are converted to \c StepRecord and filled through the same
+ * \c RootDataStore and \c HistogramRegistry used by \c SensitiveDetector .
+ *
+ * The scorer is constructed once on the master thread, and each call to
+ * \c process_steps happens on the worker thread that owns the stream, so it
+ * fills that thread's \c RootIO store directly.
+ *
+ * Scoring filters are applied, except that creator process names other than
+ * \c "primary" are unavailable from Celeritas step data and are rejected at
+ * construction. On GPU, the steps of sensitive volumes are first copied to
+ * a host buffer of the stream with \c celeritas::copy_steps .
+ *
+ * When \c "scoring_meshes" are declared, steps are gathered in every volume
+ * so that they can be scored in the meshes, and sensitive volumes are found
+ * from the pre-step volume ID instead of a Celeritas detector filter. This
+ * is only supported on host, since device steps without a detector ID are not
+ * copied.
+ */
+class BatchedStepScorer final : public celeritas::StepInterface
+{
+  public:
+    // Whether batched step scoring is selected in the JSON input
+    static bool Enabled();
+
+    // Construct with shared Celeritas problem data
+    explicit BatchedStepScorer(celeritas::CoreParams const& params);
+
+    //! Steps are gathered in sensitive volumes, or all volumes with meshes
+    Filters filters() const final { return filters_; }
+
+    //! Step data needed by the histograms
+    StepSelection selection() const final { return selection_; }
+
+    // Score a batch of host steps
+    void process_steps(HostStepState) final;
+
+    // Copy a batch of device steps to host and score it
+    void process_steps(DeviceStepState) final;
+
+  private:
+    using SPConstParticles = std::shared_ptr<celeritas::ParticleParams const>;
+    using SPConstGeo = std::shared_ptr<celeritas::GeoParams const>;
+
+    SPConstParticles particles_;
+    SPConstGeo geo_;
+    Filters filters_;
+    StepSelection selection_;
+    std::vector<ScoringFilter> sd_filters_;  //!< Indexed by DetectorId
+    bool score_meshes_{false};
+    //! Detector of each volume, indexed by volume ID when scoring meshes
+    std::vector<celeritas::DetectorId> volume_detectors_;
+    //! Host copy of the device steps, indexed by stream ID
+    std::vector<celeritas::DetectorStepOutput> device_steps_;
+
+    // Filter and score a step in a sensitive volume
+    template<class Steps, class Index>
+    void ScoreStep(Steps const& steps,
+                   Index idx,
+                   celeritas::DetectorId det,
+                   size_t depth,
+                   RootIO* rio);
+};
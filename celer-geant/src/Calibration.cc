@@ -0,0 +1,236 @@
+//------------------------------- -*- C++ -*- -------------------------------//
+// Copyright Celeritas contributors: see top-level COPYRIGHT file for details
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+//---------------------------------------------------------------------------//
+//! \file celer-geant/src/Calibration.cc
+//---------------------------------------------------------------------------//
+#include "Calibration.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <corecel/Assert.hh>
+#include <celeritas/global/CoreParams.hh>
+#include <corecel/io/Logger.hh>
+
+#include "CapacityMonitor.hh"
+#include "JsonReader.hh"
+
+namespace
+{
+//---------------------------------------------------------------------------//
+//! Candidates measured by \c Calibration::Run .
+Calibration::VecCandidate candidates;
+//! Monitor of a warm-up run.
+std::shared_ptr<CapacityMonitor const> monitor;
+
+//---------------------------------------------------------------------------//
+/*!
+ * Quote a string for the shell.
+ */
+std::string shell_quote(std::string const& s)
+{
+    std::string result = "'";
+    for (char c : s)
+    {
+        if (c == '\'')
+        {
+            result += "'\\''";
+        }
+        else
+        {
+            result += c;
+        }
+    }
+    result += "'";
+    return result;
+}
+
+//---------------------------------------------------------------------------//
+}  // namespace
+
+//---------------------------------------------------------------------------//
+/*!
+ * Whether capacity calibration is requested in the JSON input.
+ */
+bool Calibration::Enabled()
+{
+    auto const& json = JsonReader::Instance();
+    return json.contains("celeritas")
+           && json.at("celeritas").contains("calibrate");
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Run warm-up processes and select the best capacities.
+ *
+ * This must be called before \c MakeCelerOptions . Failed warm-up runs (e.g.
+ * when the initializer capacity is exceeded) are skipped.
+ */
+void Calibration::Run(std::string const& executable)
+{
+    CELER_EXPECT(Calibration::Enabled());
+
+    auto& json = JsonReader::Instance();
+    auto& celer = json.at("celeritas");
+    auto const& cal = celer.at("calibrate");
+    auto get = [&cal](char const* key, auto default_value) {
+        return cal.contains(key) ? cal.at(key).get<decltype(default_value)>()
+                                 : default_value;
+    };
+
+    JsonReader::Validate(cal, "max_num_tracks");
+    auto const num_tracks
+        = cal.at("max_num_tracks").get<std::vector<size_t>>();
+    CELER_VALIDATE(!num_tracks.empty(),
+                   << "calibration needs at least one \"max_num_tracks\"");
+    JsonReader::Validate(celer, "initializer_capacity");
+    auto const capacity = get("initializer_capacity",
+                              celer.at("initializer_capacity").get<size_t>());
+    auto const num_events = get("num_events", size_t{10});
+    auto const safety_factor = get("safety_factor", double{1.5});
+    CELER_VALIDATE(num_events > 0,
+                   << "calibration needs a positive \"num_events\"");
+    CELER_VALIDATE(safety_factor >= 1,
+                   << "calibration \"safety_factor\" must be at least 1");
+
+    JsonReader::Validate(json, "root_output");
+    auto const output = json.at("root_output").get<std::string>();
+    auto const stem = output.substr(0, output.find_last_of("."));
+
+    candidates.clear();
+    for (size_t i = 0; i < num_tracks.size(); ++i)
+    {
+        auto const prefix = stem + "-calibration-" + std::to_string(i);
+
+        // Short run without calibration or other optional outputs
+        auto input = json;
+        input["celeritas"].erase("calibrate");
+        input["celeritas"]["max_num_tracks"] = num_tracks[i];
+        input["celeritas"]["initializer_capacity"] = capacity;
+        input["particle_gun"]["num_events"] = num_events;
+        input["root_output"] = prefix + ".root";
+        input["calibration_output"] = prefix + ".json";
+        for (char const* key : {"checkpoint",
+                                "resume",
+                                "event_output",
+                                "step_records",
+                                "root_output_per_thread"})
+        {
+            input.erase(key);
+        }
+        {
+            std::ofstream os(prefix + "-input.json");
+            CELER_VALIDATE(os, << "failed to write calibration input");
+            os << input.dump(1);
+        }
+
+        Candidate c;
+        c.max_num_tracks = num_tracks[i];
+        c.initializer_capacity = capacity;
+
+        CELER_LOG(status) << "Calibrating with max_num_tracks="
+                          << c.max_num_tracks;
+        auto const cmd = shell_quote(executable) + " "
+                         + shell_quote(prefix + "-input.json") + " > "
+                         + shell_quote(prefix + ".log") + " 2>&1";
+        std::ifstream result;
+        if (std::system(cmd.c_str()) == 0)
+        {
+            result.open(prefix + ".json");
+        }
+        if (result)
+        {
+            auto const j = nlohmann::json::parse(result);
+            c.success = true;
+            c.steps_per_second = j.at("steps_per_second").get<double>();
+            c.max_initializers = j.at("max_initializers").get<size_t>();
+            CELER_LOG(info) << "Calibration with max_num_tracks="
+                            << c.max_num_tracks << ": "
+                            << c.steps_per_second << " steps/s, "
+                            << c.max_initializers << " initializers at most";
+        }
+        else
+        {
+            CELER_LOG(warning) << "Calibration with max_num_tracks="
+                               << c.max_num_tracks << " failed: see \""
+                               << prefix << ".log\"";
+        }
+        candidates.push_back(c);
+    }
+
+    auto best = std::max_element(
+        candidates.begin(), candidates.end(), [](auto const& a, auto& b) {
+            return !a.success || (b.success
+                                  && a.steps_per_second < b.steps_per_second);
+        });
+    CELER_VALIDATE(best != candidates.end() && best->success,
+                   << "every calibration run failed");
+
+    auto const init_capacity = std::max(
+        static_cast<size_t>(std::ceil(best->max_initializers * safety_factor)),
+        best->max_num_tracks);
+    celer["max_num_tracks"] = best->max_num_tracks;
+    celer["initializer_capacity"] = init_capacity;
+    CELER_LOG(info) << "Calibrated Celeritas capacities: max_num_tracks="
+                    << best->max_num_tracks
+                    << ", initializer_capacity=" << init_capacity;
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Whether this process is a calibration warm-up run.
+ */
+bool Calibration::IsWarmup()
+{
+    return JsonReader::Instance().contains("calibration_output");
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Add a capacity monitor to the Celeritas actions of a warm-up run.
+ */
+void Calibration::InsertMonitor(celeritas::CoreParams const& params)
+{
+    CELER_EXPECT(Calibration::IsWarmup());
+    auto& actions = *params.action_reg();
+    auto result = std::make_shared<CapacityMonitor>(actions.next_id());
+    actions.insert(result);
+    monitor = std::move(result);
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Write the warm-up measurements at the end of a warm-up run.
+ *
+ * This is called on the master thread with the event loop wall time.
+ */
+void Calibration::WriteWarmup(double run_time)
+{
+    CELER_EXPECT(Calibration::IsWarmup());
+    CELER_VALIDATE(monitor, << "capacity monitor was not inserted");
+
+    auto const num_steps = monitor->num_steps();
+    nlohmann::json result = {
+        {"num_steps", num_steps},
+        {"event_loop_time", run_time},
+        {"steps_per_second", run_time > 0 ? num_steps / run_time : 0.0},
+        {"max_initializers", monitor->max_initializers()},
+    };
+    auto const filename
+        = JsonReader::Instance().at("calibration_output").get<std::string>();
+    std::ofstream os(filename);
+    CELER_VALIDATE(os, << "failed to write \"" << filename << "\"");
+    os << result.dump(1);
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Measured candidates, empty if not calibrated.
+ */
+auto Calibration::Candidates() -> VecCandidate const&
+{
+    return candidates;
+}
@@ -0,0 +1,79 @@
+//------------------------------- -*- C++ -*- -------------------------------//
+// Copyright Celeritas contributors: see top-level COPYRIGHT file for details
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+//---------------------------------------------------------------------------//
+//! \file celer-geant/src/Calibration.hh
+//---------------------------------------------------------------------------//
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace celeritas
+{
+class CoreParams;
+}  // namespace celeritas
+
+//---------------------------------------------------------------------------//
+/*!
+ * Automatic calibration of the Celeritas track capacities.
+ *
+ * Celeritas allocates its track states once per run, so every candidate is
+ * measured in a short warm-up run of this executable, launched as a separate
+ * process before the production run is set up:
+ * \code
+   "celeritas": {
+       "max_num_tracks": 1024,
+       "initializer_capacity": 1048576,
+       "calibrate": {"max_num_tracks": [256, 1024, 4096],
+                     "num_events": 10,
+                     "safety_factor": 1.5}
+   }
+   \endcode
+ *
+ * Each warm-up uses the JSON \c "initializer_capacity" (or the optional
+ * \c "initializer_capacity" of the \c "calibrate" block), and records the
+ * number of track steps per second of event loop and the high-water mark of
+ * track initializers. The candidate with the highest step rate is selected,
+ * and its initializer capacity is the high-water mark times the safety
+ * factor. The selected values replace the JSON input used by
+ * \c MakeCelerOptions , and are written to the ROOT output with the
+ * measurements of every candidate.
+ *
+ * Warm-up inputs, logs, and outputs are written next to the ROOT output as
+ * \c [root_output]-calibration-[i].* .
+ */
+class Calibration
+{
+  public:
+    //! Warm-up measurement of one candidate
+    struct Candidate
+    {
+        size_t max_num_tracks{0};
+        size_t initializer_capacity{0};  //!< Warm-up capacity
+        bool success{false};
+        double steps_per_second{0};
+        size_t max_initializers{0};
+    };
+
+    using VecCandidate = std::vector<Candidate>;
+
+  public:
+    // Whether capacity calibration is requested in the JSON input
+    static bool Enabled();
+
+    // Run warm-up processes and select the best capacities
+    static void Run(std::string const& executable);
+
+    // Whether this process is a calibration warm-up run
+    static bool IsWarmup();
+
+    // Add a capacity monitor to the Celeritas actions of a warm-up run
+    static void InsertMonitor(celeritas::CoreParams const& params);
+
+    // Write the warm-up measurements at the end of a warm-up run
+    static void WriteWarmup(double run_time);
+
+    // Measured candidates, empty if not calibrated
+    static VecCandidate const& Candidates();
+};
@@ -0,0 +1,59 @@
+//------------------------------- -*- C++ -*- -------------------------------//
+// Copyright Celeritas contributors: see top-level COPYRIGHT file for details
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+//---------------------------------------------------------------------------//
+//! \file celer-geant/src/CapacityMonitor.cc
+//---------------------------------------------------------------------------//
+#include "CapacityMonitor.hh"
+
+//---------------------------------------------------------------------------//
+/*!
+ * Construct with action ID.
+ */
+CapacityMonitor::CapacityMonitor(celeritas::ActionId id)
+    : celeritas::ConcreteAction(id,
+                                "capacity-monitor",
+                                "record track slot and initializer usage")
+{
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Record counters of a host state.
+ */
+void CapacityMonitor::step(celeritas::CoreParams const&,
+                           celeritas::CoreStateHost& state) const
+{
+    this->Record(state.counters());
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Record counters of a device state.
+ *
+ * State counters are kept on the host, so no device copy is needed.
+ */
+void CapacityMonitor::step(celeritas::CoreParams const&,
+                           celeritas::CoreStateDevice& state) const
+{
+    this->Record(state.counters());
+}
+
+//---------------------------------------------------------------------------//
+// PRIVATE
+//---------------------------------------------------------------------------//
+/*!
+ * Accumulate the counters of a step iteration.
+ */
+void CapacityMonitor::Record(
+    celeritas::CoreStateCounters const& counters) const
+{
+    num_steps_ += counters.num_active;
+
+    size_t const num_init = counters.num_initializers;
+    size_t prev = max_initializers_.load();
+    while (prev < num_init
+           && !max_initializers_.compare_exchange_weak(prev, num_init))
+    {
+    }
+}
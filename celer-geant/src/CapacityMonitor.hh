@@ -0,0 +1,56 @@
+//------------------------------- -*- C++ -*- -------------------------------//
+// Copyright Celeritas contributors: see top-level COPYRIGHT file for details
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+//---------------------------------------------------------------------------//
+//! \file celer-geant/src/CapacityMonitor.hh
+//---------------------------------------------------------------------------//
+#pragma once
+
+#include <atomic>
+#include <celeritas/global/ActionInterface.hh>
+#include <celeritas/global/CoreParams.hh>
+#include <celeritas/global/CoreState.hh>
+
+//---------------------------------------------------------------------------//
+/*!
+ * Record Celeritas track-slot usage at the end of every step iteration.
+ *
+ * The number of active tracks summed over step iterations is the number of
+ * track steps taken, and the largest number of queued track initializers is
+ * the high-water mark that the \c initializer_capacity must accommodate.
+ * Counters are accumulated over every stream with atomics, since streams
+ * step concurrently on their worker threads.
+ */
+class CapacityMonitor final : public celeritas::CoreStepActionInterface,
+                              public celeritas::ConcreteAction
+{
+  public:
+    // Construct with action ID
+    explicit CapacityMonitor(celeritas::ActionId id);
+
+    // Record counters of a host state
+    void step(celeritas::CoreParams const&,
+              celeritas::CoreStateHost& state) const final;
+
+    // Record counters of a device state
+    void step(celeritas::CoreParams const&,
+              celeritas::CoreStateDevice& state) const final;
+
+    //! Run after every other action of a step iteration
+    celeritas::StepActionOrder order() const final
+    {
+        return celeritas::StepActionOrder::end;
+    }
+
+    //! Number of track steps taken
+    size_t num_steps() const { return num_steps_.load(); }
+
+    //! Largest number of track initializers in a stream
+    size_t max_initializers() const { return max_initializers_.load(); }
+
+  private:
+    mutable std::atomic<size_t> num_steps_{0};
+    mutable std::atomic<size_t> max_initializers_{0};
+
+    void Record(celeritas::CoreStateCounters const& counters) const;
+};
@@ -0,0 +1,544 @@
+//------------------------------- -*- C++ -*- -------------------------------//
+// Copyright Celeritas contributors: see top-level COPYRIGHT file for details
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+//---------------------------------------------------------------------------//
+//! \file celer-geant/src/Checkpoint.cc
+//---------------------------------------------------------------------------//
+#include "Checkpoint.hh"
+
+#include <algorithm>
+#include <cstdio>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <vector>
+#include <TFile.h>
+#include <TTree.h>
+#include <corecel/Assert.hh>
+#include <corecel/io/Logger.hh>
+
+namespace
+{
+//---------------------------------------------------------------------------//
+/*!
+ * Call a function with the 1D or 2D histogram of a definition.
+ */
+template<class H, class F>
+void visit_hist(H& hists, HistogramRegistry::Definition const& def, F&& func)
+{
+    if (def.dim == 1)
+    {
+        func(hists.h1d[def.index]);
+    }
+    else
+    {
+        func(hists.h2d[def.index]);
+    }
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Scoring mesh voxels stored as one column per bin sum.
+ */
+struct MeshColumns
+{
+    std::vector<double> sum_w;
+    std::vector<double> sum_w2;
+
+    //! Copy the sums of completed events
+    void Assign(MeshTally::VecBin const& bins)
+    {
+        sum_w.resize(bins.size());
+        sum_w2.resize(bins.size());
+        for (size_t i = 0; i < bins.size(); ++i)
+        {
+            CELER_ASSERT(!bins[i].pending);
+            sum_w[i] = bins[i].sum_w;
+            sum_w2[i] = bins[i].sum_w2;
+        }
+    }
+
+    //! Restore the sums into allocated voxels
+    void CopyTo(MeshTally::VecBin* bins) const
+    {
+        CELER_EXPECT(bins->size() == sum_w.size());
+        for (size_t i = 0; i < sum_w.size(); ++i)
+        {
+            (*bins)[i].sum_w = sum_w[i];
+            (*bins)[i].sum_w2 = sum_w2[i];
+        }
+    }
+};
+
+//---------------------------------------------------------------------------//
+/*!
+ * Get a tree from a checkpoint file.
+ */
+std::unique_ptr<TTree> get_tree(TFile& file, char const* name)
+{
+    std::unique_ptr<TTree> result(file.Get<TTree>(name));
+    CELER_VALIDATE(result,
+                   << "checkpoint file \"" << file.GetName()
+                   << "\" has no '" << name << "' tree");
+    return result;
+}
+
+//---------------------------------------------------------------------------//
+}  // namespace
+
+//---------------------------------------------------------------------------//
+/*!
+ * Read a checkpoint file.
+ *
+ * The histogram registry and scoring meshes are built from the current JSON
+ * input, whose histogram and mesh names must match the ones in the
+ * checkpoint.
+ */
+Checkpoint Checkpoint::Read(std::string const& filename)
+{
+    std::unique_ptr<TFile> file(TFile::Open(filename.c_str(), "read"));
+    CELER_VALIDATE(file && !file->IsZombie(),
+                   << "failed to open checkpoint file \"" << filename << "\"");
+
+    Checkpoint result;
+
+    // Run metadata
+    ULong64_t num_events{};
+    ULong64_t num_steps{};
+    ULong64_t seed{};
+    std::vector<ULong64_t> event_begin;
+    std::vector<ULong64_t> event_end;
+    std::vector<std::string> hist_names;
+    {
+        auto tree = get_tree(*file, "checkpoint");
+        auto* begin_ptr = &event_begin;
+        auto* end_ptr = &event_end;
+        auto* names_ptr = &hist_names;
+        tree->SetBranchAddress("num_events", &num_events);
+        tree->SetBranchAddress("num_steps", &num_steps);
+        tree->SetBranchAddress("seed", &seed);
+        tree->SetBranchAddress("event_begin", &begin_ptr);
+        tree->SetBranchAddress("event_end", &end_ptr);
+        tree->SetBranchAddress("histograms", &names_ptr);
+        CELER_VALIDATE(tree->GetEntry(0) > 0,
+                       << "checkpoint file \"" << filename
+                       << "\" has no metadata");
+    }
+    result.seed = seed;
+    CELER_ASSERT(event_begin.size() == event_end.size());
+    for (size_t i = 0; i < event_begin.size(); ++i)
+    {
+        result.events.Insert(EventRanges::Range{event_begin[i], event_end[i]});
+    }
+
+    // Sensitive detectors
+    std::vector<std::string> sd_names;
+    std::vector<ULong64_t> sd_touched;
+    std::vector<std::vector<ULong64_t>> sd_entries;
+    {
+        auto tree = get_tree(*file, "sensitive_detectors");
+        std::string sd_name;
+        ULong64_t num_touched_events{};
+        std::vector<ULong64_t> num_entries;
+        auto* name_ptr = &sd_name;
+        auto* entries_ptr = &num_entries;
+        tree->SetBranchAddress("sd_name", &name_ptr);
+        tree->SetBranchAddress("num_touched_events", &num_touched_events);
+        tree->SetBranchAddress("num_entries", &entries_ptr);
+        for (Long64_t i = 0; i < tree->GetEntries(); ++i)
+        {
+            tree->GetEntry(i);
+            sd_names.push_back(sd_name);
+            sd_touched.push_back(num_touched_events);
+            sd_entries.push_back(num_entries);
+        }
+    }
+
+    // Placeholder placements: the store is only merged and written
+    auto& store = result.store;
+    for (size_t i = 0; i < sd_names.size(); ++i)
+    {
+        store.InsertSensDet(i, 0, std::move(sd_names[i]));
+    }
+    store.Initialize();
+    store.AddCounts(num_events, num_steps);
+
+    auto const& registry = store.Registry();
+    auto const& defs = registry.Definitions();
+    CELER_VALIDATE(hist_names.size() == defs.size(),
+                   << "checkpoint file \"" << filename << "\" has "
+                   << hist_names.size() << " histograms but the input has "
+                   << defs.size());
+    for (size_t i = 0; i < defs.size(); ++i)
+    {
+        CELER_VALIDATE(hist_names[i] == defs[i].name,
+                       << "checkpoint histogram '" << hist_names[i]
+                       << "' does not match input histogram '"
+                       << defs[i].name << "'");
+    }
+
+    auto& sensdets = store.SensDets();
+    CELER_ASSERT(sensdets.size() == sd_entries.size());
+    for (size_t i = 0; i < sensdets.size(); ++i)
+    {
+        auto& data = sensdets[i];
+        data.num_touched_events = sd_touched[i];
+        if (sd_entries[i].empty())
+        {
+            // Never hit
+            continue;
+        }
+        CELER_VALIDATE(sd_entries[i].size() == defs.size(),
+                       << "inconsistent histograms for '" << data.sd_name
+                       << "' in checkpoint file \"" << filename << "\"");
+        data.hists = std::make_unique<SensDetHistograms>(registry.Prototype());
+        for (size_t j = 0; j < defs.size(); ++j)
+        {
+            visit_hist(*data.hists, defs[j], [&](auto& hist) {
+                hist.AddEntries(sd_entries[i][j]);
+            });
+        }
+    }
+
+    // Histogram bins
+    {
+        auto tree = get_tree(*file, "bins");
+        UInt_t sd{};
+        UInt_t hist{};
+        ULong64_t index{};
+        HistogramBin bin;
+        tree->SetBranchAddress("sd", &sd);
+        tree->SetBranchAddress("hist", &hist);
+        tree->SetBranchAddress("bin", &index);
+        tree->SetBranchAddress("sum_w", &bin.sum_w);
+        tree->SetBranchAddress("sum_w2", &bin.sum_w2);
+        for (Long64_t i = 0; i < tree->GetEntries(); ++i)
+        {
+            tree->GetEntry(i);
+            CELER_VALIDATE(sd < sensdets.size() && hist < defs.size()
+                               && sensdets[sd].hists,
+                           << "invalid bin in checkpoint file \"" << filename
+                           << "\"");
+            visit_hist(*sensdets[sd].hists, defs[hist], [&](auto& h) {
+                h.AddBin(index, bin);
+            });
+        }
+    }
+
+    // Scoring mesh tallies
+    {
+        auto tree = get_tree(*file, "meshes");
+        auto const& meshes = store.Meshes();
+        auto& tallies = store.MeshTallies();
+        CELER_VALIDATE(tree->GetEntries() == Long64_t(meshes.size()),
+                       << "checkpoint file \"" << filename << "\" has "
+                       << tree->GetEntries()
+                       << " scoring meshes but the input has "
+                       << meshes.size());
+        std::string name;
+        MeshColumns edep;
+        MeshColumns track_length;
+        auto* name_ptr = &name;
+        std::vector<double>* columns[] = {&edep.sum_w,
+                                          &edep.sum_w2,
+                                          &track_length.sum_w,
+                                          &track_length.sum_w2};
+        tree->SetBranchAddress("name", &name_ptr);
+        tree->SetBranchAddress("edep", &columns[0]);
+        tree->SetBranchAddress("edep_w2", &columns[1]);
+        tree->SetBranchAddress("track_length", &columns[2]);
+        tree->SetBranchAddress("track_length_w2", &columns[3]);
+        for (size_t i = 0; i < meshes.size(); ++i)
+        {
+            tree->GetEntry(i);
+            auto const size = tallies[i].edep.size();
+            CELER_VALIDATE(name == meshes[i].name()
+                               && std::all_of(std::begin(columns),
+                                              std::end(columns),
+                                              [size](auto const* c) {
+                                                  return c->size() == size;
+                                              }),
+                           << "checkpoint scoring mesh '" << name
+                           << "' does not match input mesh '"
+                           << meshes[i].name() << "'");
+            edep.CopyTo(&tallies[i].edep);
+            track_length.CopyTo(&tallies[i].track_length);
+        }
+    }
+
+    file->Close();
+    return result;
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Write to a checkpoint file, replacing it atomically.
+ *
+ * The data is first written to a temporary file, which is then renamed, so
+ * that a job killed while writing keeps the previous checkpoint intact.
+ */
+void Checkpoint::Write(std::string const& filename) const
+{
+    CELER_EXPECT(!filename.empty());
+    auto const tmp_filename = filename + ".tmp";
+    std::unique_ptr<TFile> file(
+        TFile::Open(tmp_filename.c_str(), "recreate"));
+    CELER_VALIDATE(file && !file->IsZombie(),
+                   << "failed to open checkpoint file \"" << tmp_filename
+                   << "\"");
+    file->cd();
+
+    auto const& defs = store.Registry().Definitions();
+    auto const& sensdets = store.SensDets();
+
+    {
+        // Run metadata
+        TTree tree("checkpoint", "checkpoint");
+        ULong64_t num_events = store.NumEvents();
+        ULong64_t num_steps = store.NumSteps();
+        ULong64_t event_seed = seed;
+        std::vector<ULong64_t> event_begin;
+        std::vector<ULong64_t> event_end;
+        for (auto const& r : events.ranges())
+        {
+            event_begin.push_back(r.first);
+            event_end.push_back(r.second);
+        }
+        std::vector<std::string> hist_names;
+        for (auto const& def : defs)
+        {
+            hist_names.push_back(def.name);
+        }
+        tree.Branch("num_events", &num_events);
+        tree.Branch("num_steps", &num_steps);
+        tree.Branch("seed", &event_seed);
+        tree.Branch("event_begin", &event_begin);
+        tree.Branch("event_end", &event_end);
+        tree.Branch("histograms", &hist_names);
+        tree.Fill();
+        tree.Write();
+    }
+
+    {
+        // Per-SD bookkeeping; SDs that were never hit have no entries
+        TTree tree("sensitive_detectors", "sensitive_detectors");
+        std::string sd_name;
+        ULong64_t num_touched_events{};
+        std::vector<ULong64_t> num_entries;
+        tree.Branch("sd_name", &sd_name);
+        tree.Branch("num_touched_events", &num_touched_events);
+        tree.Branch("num_entries", &num_entries);
+        for (auto const& data : sensdets)
+        {
+            sd_name = data.sd_name;
+            num_touched_events = data.num_touched_events;
+            num_entries.clear();
+            if (data.hists)
+            {
+                for (auto const& def : defs)
+                {
+                    visit_hist(*data.hists, def, [&](auto const& hist) {
+                        num_entries.push_back(hist.num_entries());
+                    });
+                }
+            }
+            tree.Fill();
+        }
+        tree.Write();
+    }
+
+    {
+        // Non-empty bins of every histogram
+        TTree tree("bins", "bins");
+        UInt_t sd{};
+        UInt_t hist{};
+        ULong64_t index{};
+        HistogramBin bin;
+        tree.Branch("sd", &sd);
+        tree.Branch("hist", &hist);
+        tree.Branch("bin", &index);
+        tree.Branch("sum_w", &bin.sum_w);
+        tree.Branch("sum_w2", &bin.sum_w2);
+        for (sd = 0; sd < sensdets.size(); ++sd)
+        {
+            if (!sensdets[sd].hists)
+            {
+                continue;
+            }
+            for (hist = 0; hist < defs.size(); ++hist)
+            {
+                visit_hist(*sensdets[sd].hists, defs[hist], [&](auto& h) {
+                    h.ForEachBin([&](size_t i, HistogramBin const& b) {
+                        if (b.sum_w2 == 0)
+                        {
+                            return;
+                        }
+                        index = i;
+                        bin = b;
+                        tree.Fill();
+                    });
+                });
+            }
+        }
+        tree.Write();
+    }
+
+    {
+        // Dense scoring mesh tallies
+        TTree tree("meshes", "meshes");
+        std::string name;
+        MeshColumns edep;
+        MeshColumns track_length;
+        tree.Branch("name", &name);
+        tree.Branch("edep", &edep.sum_w);
+        tree.Branch("edep_w2", &edep.sum_w2);
+        tree.Branch("track_length", &track_length.sum_w);
+        tree.Branch("track_length_w2", &track_length.sum_w2);
+        auto const& meshes = store.Meshes();
+        for (size_t i = 0; i < meshes.size(); ++i)
+        {
+            auto const& tally = store.MeshTallies()[i];
+            name = meshes[i].name();
+            edep.Assign(tally.edep);
+            track_length.Assign(tally.track_length);
+            tree.Fill();
+        }
+        tree.Write();
+    }
+
+    file->Close();
+    CELER_VALIDATE(std::rename(tmp_filename.c_str(), filename.c_str()) == 0,
+                   << "failed to replace checkpoint file \"" << filename
+                   << "\"");
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Construct and start the writer thread.
+ */
+CheckpointWriter::CheckpointWriter(std::string filename,
+                                   size_t event_interval,
+                                   double time_interval,
+                                   std::uint64_t seed)
+    : filename_(std::move(filename))
+    , event_interval_(event_interval)
+    , time_interval_(time_interval)
+{
+    CELER_VALIDATE(!filename_.empty(),
+                   << "checkpoint filename must be non-empty");
+    CELER_VALIDATE(event_interval_ > 0 || time_interval_ > 0,
+                   << "checkpoint needs a positive event or time interval");
+    snapshot_.seed = seed;
+    thread_ = std::thread(&CheckpointWriter::Run, this);
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Stop the writer thread.
+ */
+CheckpointWriter::~CheckpointWriter()
+{
+    this->Close();
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Count a completed event and snapshot the store if a checkpoint is due.
+ *
+ * This must be called after the store has finished the event.
+ */
+void CheckpointWriter::EndEvent(RootDataStore const& store,
+                                EventRanges const& events)
+{
+    ++num_events_;
+    bool const due = (event_interval_ > 0 && num_events_ >= event_interval_)
+                     || (time_interval_ > 0 && timer_() >= time_interval_);
+    if (!due)
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (pending_)
+        {
+            // Previous checkpoint is still being written: try again later
+            ++num_deferred_;
+            return;
+        }
+    }
+
+    // The writer thread is idle, so the snapshot is not shared
+    store.CopyTo(&snapshot_.store);
+    snapshot_.events = events;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_ = true;
+    }
+    cv_.notify_all();
+
+    num_events_ = 0;
+    timer_ = {};
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Wait for the pending checkpoint and stop the writer thread.
+ */
+void CheckpointWriter::Close()
+{
+    if (!thread_.joinable())
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closing_ = true;
+    }
+    cv_.notify_all();
+    thread_.join();
+
+    if (num_deferred_ > 0)
+    {
+        CELER_LOG_LOCAL(debug) << "Checkpoints to \"" << filename_
+                               << "\" were deferred at " << num_deferred_
+                               << " events while the writer was busy";
+    }
+}
+
+//---------------------------------------------------------------------------//
+// PRIVATE
+//---------------------------------------------------------------------------//
+/*!
+ * Background thread loop.
+ *
+ * Write errors are logged rather than thrown, so that a failed checkpoint
+ * does not abort the run.
+ */
+void CheckpointWriter::Run()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true)
+    {
+        cv_.wait(lock, [this] { return pending_ || closing_; });
+        if (!pending_)
+        {
+            break;
+        }
+
+        lock.unlock();
+        try
+        {
+            snapshot_.Write(filename_);
+            CELER_LOG(debug) << "Wrote checkpoint of "
+                             << snapshot_.events.size() << " events to \""
+                             << filename_ << "\"";
+        }
+        catch (std::exception const& e)
+        {
+            CELER_LOG(error) << "Failed to write checkpoint: " << e.what();
+        }
+        lock.lock();
+        pending_ = false;
+    }
+}
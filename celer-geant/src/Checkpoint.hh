@@ -0,0 +1,101 @@
+//------------------------------- -*- C++ -*- -------------------------------//
+// Copyright Celeritas contributors: see top-level COPYRIGHT file for details
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+//---------------------------------------------------------------------------//
+//! \file celer-geant/src/Checkpoint.hh
+//---------------------------------------------------------------------------//
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <corecel/sys/Stopwatch.hh>
+
+#include "EventRanges.hh"
+#include "RootDataStore.hh"
+
+//---------------------------------------------------------------------------//
+/*!
+ * Accumulated scoring data of a partial run.
+ *
+ * A checkpoint holds the data store of one worker thread (or the merged
+ * stores of a resumed run), the IDs of the events it contains, and the seed
+ * used to sample them. Histograms are saved as raw bin sums rather than ROOT
+ * histograms, and scoring mesh tallies as dense arrays, so that restoring and
+ * merging them is exact.
+ *
+ * The store keeps the raw per-SD touched-event counts, without zero entries
+ * for untouched events: those are only filled by \c RootIO::FinalizeMaster
+ * once the checkpoint is merged with the stores of every thread.
+ */
+struct Checkpoint
+{
+    RootDataStore store;
+    EventRanges events;
+    std::uint64_t seed{0};
+
+    // Read a checkpoint file
+    static Checkpoint Read(std::string const& filename);
+
+    // Write to a checkpoint file, replacing it atomically
+    void Write(std::string const& filename) const;
+};
+
+//---------------------------------------------------------------------------//
+/*!
+ * Periodic, non-blocking checkpoint writer owned by a worker thread.
+ *
+ * A checkpoint is due every \c event_interval events or \c time_interval
+ * seconds of wall time (either may be zero to disable it). At the end of a
+ * due event the live store is copied into a snapshot, which is then written by
+ * a background thread while the worker keeps tracking: the live store and the
+ * snapshot form a double buffer, and the snapshot allocations are reused from
+ * one checkpoint to the next.
+ *
+ * If the previous checkpoint is still being written, the snapshot is deferred
+ * to the next event instead of waiting for the writer.
+ */
+class CheckpointWriter
+{
+  public:
+    // Construct and start the writer thread
+    CheckpointWriter(std::string filename,
+                     size_t event_interval,
+                     double time_interval,
+                     std::uint64_t seed);
+
+    // Stop the writer thread
+    ~CheckpointWriter();
+
+    //!@{
+    //! Prevent copying and moving
+    CheckpointWriter(CheckpointWriter const&) = delete;
+    CheckpointWriter& operator=(CheckpointWriter const&) = delete;
+    //!@}
+
+    // Count a completed event and snapshot the store if a checkpoint is due
+    void EndEvent(RootDataStore const& store, EventRanges const& events);
+
+    // Wait for the pending checkpoint and stop the writer thread
+    void Close();
+
+  private:
+    std::string filename_;
+    size_t event_interval_;
+    double time_interval_;
+    size_t num_events_{0};  //!< Events since the last checkpoint
+    size_t num_deferred_{0};  //!< Events at which the writer was busy
+    celeritas::Stopwatch timer_;
+
+    Checkpoint snapshot_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool pending_{false};  //!< Snapshot is owned by the writer thread
+    bool closing_{false};
+    std::thread thread_;
+
+    // Background thread loop
+    void Run();
+};
@@ -0,0 +1,189 @@
+//------------------------------- -*- C++ -*- -------------------------------//
+// Copyright Celeritas contributors: see top-level COPYRIGHT file for details
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+//---------------------------------------------------------------------------//
+//! \file celer-geant/src/Config.cc
+//---------------------------------------------------------------------------//
+#include "Config.hh"
+
+#include <G4Threading.hh>
+#include <corecel/Assert.hh>
+
+#include "JsonReader.hh"
+
+namespace
+{
+//---------------------------------------------------------------------------//
+//! Singleton declaration.
+std::unique_ptr<Config const> config_singleton;
+
+//---------------------------------------------------------------------------//
+/*!
+ * Load the optional \c "scoring_aggregation" level.
+ */
+ScoringAggregation load_aggregation(nlohmann::json const& json)
+{
+    if (!json.contains("scoring_aggregation"))
+    {
+        return ScoringAggregation::placement;
+    }
+
+    auto const level = json.at("scoring_aggregation").get<std::string>();
+    if (level == "placement")
+    {
+        return ScoringAggregation::placement;
+    }
+    if (level == "logical_volume")
+    {
+        return ScoringAggregation::logical_volume;
+    }
+    CELER_VALIDATE(level == "sensitive_detector",
+                   << "unknown scoring aggregation '" << level
+                   << "' (expected \"placement\", \"logical_volume\", or "
+                      "\"sensitive_detector\")");
+    return ScoringAggregation::sensitive_detector;
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Load the optional \c "offload_policy" of the \c "celeritas" block.
+ */
+OffloadPolicy load_offload_policy(nlohmann::json const& json)
+{
+    OffloadPolicy result;
+    if (!json.contains("celeritas")
+        || !json.at("celeritas").contains("offload_policy"))
+    {
+        return result;
+    }
+
+    auto const& j = json.at("celeritas").at("offload_policy");
+    if (j.contains("min_energy"))
+    {
+        result.min_energy = j.at("min_energy").get<double>();
+        CELER_VALIDATE(result.min_energy >= 0,
+                       << "offload policy \"min_energy\" must not be "
+                          "negative");
+    }
+    if (j.contains("regions"))
+    {
+        result.regions = j.at("regions").get<std::vector<std::string>>();
+        CELER_VALIDATE(!result.regions.empty(),
+                       << "offload policy \"regions\" is empty");
+    }
+    return result;
+}
+
+//---------------------------------------------------------------------------//
+}  // namespace
+
+//---------------------------------------------------------------------------//
+/*!
+ * Parse and validate the JSON input on the master thread.
+ *
+ * This must be called once, after \c JsonReader::Construct and any change
+ * to the JSON input (e.g. by \c Calibration::Run ), and before worker threads
+ * are started.
+ */
+void Config::Construct()
+{
+    CELER_VALIDATE(G4Threading::IsMasterThread(),
+                   << "Must be called on master thread");
+    CELER_VALIDATE(!config_singleton, << "Config already constructed");
+
+    auto const& json = JsonReader::Instance();
+    auto result = std::make_unique<Config>();
+
+    JsonReader::Validate(json, "num_threads");
+    result->num_threads = json.at("num_threads").get<size_t>();
+    CELER_VALIDATE(result->num_threads > 0,
+                   << "Number of threads must be positive");
+
+    if (json.contains("run_manager"))
+    {
+        auto const type = json.at("run_manager").get<std::string>();
+        CELER_VALIDATE(type == "mt" || type == "tasking",
+                       << "unknown run manager '" << type
+                       << "' (expected \"mt\" or \"tasking\")");
+        result->tasking = type == "tasking";
+    }
+    if (json.contains("events_per_task"))
+    {
+        result->events_per_task = json.at("events_per_task").get<size_t>();
+        CELER_VALIDATE(result->events_per_task > 0,
+                       << "\"events_per_task\" must be positive");
+    }
+
+    JsonReader::Validate(json, "particle_gun");
+    JsonReader::Validate(json.at("particle_gun"), "num_events");
+    result->num_events
+        = json.at("particle_gun").at("num_events").get<size_t>();
+    CELER_VALIDATE(result->num_events > 0,
+                   << "Number of events must be positive");
+
+    if (json.contains("log_progress"))
+    {
+        result->log_progress = json.at("log_progress").get<size_t>();
+        CELER_VALIDATE(result->log_progress > 0,
+                       << "\"log_progress\" must be positive");
+    }
+
+    if (json.contains("affinity"))
+    {
+        result->affinity = ThreadAffinity(json.at("affinity"));
+    }
+
+    JsonReader::Validate(json, "geometry");
+    result->geometry = json.at("geometry").get<std::string>();
+    JsonReader::Validate(json, "all_volumes_sensitive");
+    result->all_volumes_sensitive
+        = json.at("all_volumes_sensitive").get<bool>();
+
+    result->aggregation = load_aggregation(json);
+    result->offload_pdgs = ScoringFilter::OffloadPdgs();
+    result->offload_policy = load_offload_policy(json);
+
+    JsonReader::Validate(json, "histograms");
+    result->histograms
+        = std::make_shared<HistogramRegistry const>(json.at("histograms"));
+    result->meshes = std::make_shared<ScoringMesh::VecMesh const>(
+        ScoringMesh::FromJson());
+
+    JsonReader::Validate(json, "root_output");
+    result->root_output = json.at("root_output").get<std::string>();
+    result->root_output_per_thread
+        = json.contains("root_output_per_thread")
+          && json.at("root_output_per_thread").get<bool>();
+
+    result->default_filter = ScoringFilter(nlohmann::json::object());
+    if (json.contains("scoring_filters"))
+    {
+        for (auto const& [name, input] : json.at("scoring_filters").items())
+        {
+            if (name == "default")
+            {
+                result->default_filter = ScoringFilter(input);
+            }
+            else
+            {
+                result->filters.emplace(name, ScoringFilter(input));
+            }
+        }
+    }
+
+    config_singleton = std::move(result);
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Shared read-only configuration.
+ *
+ * \note \c Config::Construct() must be called to construct it.
+ */
+Config const& Config::Instance()
+{
+    CELER_VALIDATE(config_singleton,
+                   << "Config not constructed. Initialize it by calling "
+                      "Config::Construct().");
+    return *config_singleton;
+}
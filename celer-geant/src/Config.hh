@@ -0,0 +1,133 @@
+//------------------------------- -*- C++ -*- -------------------------------//
+// Copyright Celeritas contributors: see top-level COPYRIGHT file for details
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+//---------------------------------------------------------------------------//
+//! \file celer-geant/src/Config.hh
+//---------------------------------------------------------------------------//
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "HistogramRegistry.hh"
+#include "PdgSet.hh"
+#include "ScoringFilter.hh"
+#include "ScoringMesh.hh"
+#include "ThreadAffinity.hh"
+
+//---------------------------------------------------------------------------//
+/*!
+ * Level at which sensitive detector placements share histograms.
+ *
+ * - \c placement : one set of histograms per physical volume instance and
+ *   copy number (default), named \c [sd]_[instance_id]_[copy_num] .
+ * - \c logical_volume : one set per logical volume, named
+ *   \c [sd]_[logical_volume] .
+ * - \c sensitive_detector : one set per sensitive detector name.
+ */
+enum class ScoringAggregation
+{
+    placement,
+    logical_volume,
+    sensitive_detector
+};
+
+//---------------------------------------------------------------------------//
+/*!
+ * Conditions for offloading a track of an offloaded particle type.
+ *
+ * Tracks below the energy threshold, or outside every listed region, are
+ * transported by Geant4 instead (see \c HybridTrackingManager ).
+ */
+struct OffloadPolicy
+{
+    double min_energy{0};  //!< Minimum kinetic energy [MeV]
+    std::vector<std::string> regions;  //!< G4Region names, any if empty
+
+    //! Whether some tracks may stay in Geant4
+    bool enabled() const { return min_energy > 0 || !regions.empty(); }
+};
+
+//---------------------------------------------------------------------------//
+/*!
+ * Typed application settings, parsed and validated once.
+ *
+ * \c Config::Construct() reads the \c JsonReader input on the master thread,
+ * before the run manager is created, and \c Config::Instance() shares the
+ * result read-only with every worker thread. Settings that are needed per
+ * sensitive detector or per thread (histogram declarations, scoring meshes,
+ * compiled scoring filters) are thus built once instead of being looked up
+ * in the JSON document for every SD.
+ *
+ * Blocks that are only read once during setup (\c "celeritas" , \c "field" ,
+ * \c "hepmc3" , \c "checkpoint" , ...) are still parsed by their owners.
+ */
+struct Config
+{
+    //!@{
+    //! \name Run
+    size_t num_threads{0};  //!< Worker threads or thread pool size
+    bool tasking{false};  //!< Use the task-based run manager
+    size_t events_per_task{0};  //!< Geant4 default if zero
+    size_t num_events{0};  //!< Including events of a resumed run
+    size_t log_progress{1};  //!< Log every N events
+    ThreadAffinity affinity;  //!< CPU pinning of worker threads
+    //!@}
+
+    //!@{
+    //! \name Geometry
+    std::string geometry;  //!< GDML filename
+    bool all_volumes_sensitive{false};
+    //!@}
+
+    //!@{
+    //! \name Scoring
+    ScoringAggregation aggregation{ScoringAggregation::placement};
+    PdgSet offload_pdgs;
+    OffloadPolicy offload_policy;
+    std::shared_ptr<HistogramRegistry const> histograms;
+    std::shared_ptr<ScoringMesh::VecMesh const> meshes;
+    //!@}
+
+    //!@{
+    //! \name Output
+    std::string root_output;
+    bool root_output_per_thread{false};
+    //!@}
+
+    //// FILTERS ////
+
+    std::unordered_map<std::string, ScoringFilter> filters;  //!< By SD name
+    ScoringFilter default_filter;
+
+    // Scoring filter of a sensitive detector
+    inline ScoringFilter const& Filter(std::string const& sd_name) const;
+
+    //! Whether any scoring mesh is declared
+    bool HasMeshes() const { return meshes && !meshes->empty(); }
+
+    //// SINGLETON ////
+
+    // Parse and validate the JSON input on the master thread
+    static void Construct();
+
+    // Shared read-only configuration
+    static Config const& Instance();
+};
+
+//---------------------------------------------------------------------------//
+// INLINE DEFINITIONS
+//---------------------------------------------------------------------------//
+/*!
+ * Scoring filter of a sensitive detector.
+ *
+ * The SD-specific entry replaces the \c "default" one entirely. Filters keep
+ * a per-thread cache, so callers must copy the returned prototype.
+ */
+ScoringFilter const& Config::Filter(std::string const& sd_name) const
+{
+    auto iter = filters.find(sd_name);
+    return iter != filters.end() ? iter->second : default_filter;
+}
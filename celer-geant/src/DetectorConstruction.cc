@@ -6,15 +6,25 @@
 //---------------------------------------------------------------------------//
 #include "DetectorConstruction.hh"
 
+#include <set>
 #include <G4LogicalVolume.hh>
 #include <G4PhysicalVolumeStore.hh>
 #include <G4SDManager.hh>
 #include <corecel/Assert.hh>
 #include <corecel/io/Logger.hh>
 
-#include "JsonReader.hh"
+#include "Config.hh"
+#include "FieldSetup.hh"
 #include "SensitiveDetector.hh"
 
+namespace
+{
+//---------------------------------------------------------------------------//
+//! Sensitive volumes, found on the master thread in \c Construct
+DetectorConstruction::VecSensitiveVolume sensitive_volumes;
+//---------------------------------------------------------------------------//
+}  // namespace
+
 //---------------------------------------------------------------------------//
 /*!
  * Construct with filename.
@@ -30,10 +40,13 @@ DetectorConstruction::DetectorConstruction(std::string gdml_filename)
 
 //---------------------------------------------------------------------------//
 /*!
- * Construct world geometry.
+ * Construct world geometry and find sensitive volumes.
  */
 G4VPhysicalVolume* DetectorConstruction::Construct()
 {
+    sensitive_volumes = Config::Instance().all_volumes_sensitive
+                            ? this->FindAllVolumes()
+                            : this->FindGdmlSensitiveVolumes();
     return parser_.GetWorldVolume();
 }
 
@@ -43,36 +56,50 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
  */
 void DetectorConstruction::ConstructSDandField()
 {
-    if (false /* field */)
+    if (FieldSetup::Enabled())
     {
-        //! \todo Initialize field
-        CELER_LOG(status) << "Initializing magnetic field";
+        CELER_LOG_LOCAL(status) << "Initializing magnetic field";
+        FieldSetup::ConstructField();
     }
 
-    auto const& json = JsonReader::Instance();
-    JsonReader::Validate(json, "all_volumes_sensitive");
-    if (json.at("all_volumes_sensitive").get<bool>())
-    {
-        this->MakeAllVolumesSensitive();
-    }
-    else
+    CELER_LOG_LOCAL(status) << "Initializing sensitive detectors";
+    auto sd_manager = G4SDManager::GetSDMpointer();
+    CELER_ASSERT(sd_manager);
+
+    for (auto const& sv : sensitive_volumes)
     {
-        this->InitializeSensitiveDetectors();
+        auto this_sd = std::make_unique<SensitiveDetector>(sv.sd_name);
+        G4VUserDetectorConstruction::SetSensitiveDetector(sv.logvol,
+                                                          this_sd.get());
+        sd_manager->AddNewDetector(this_sd.release());
+        CELER_LOG(debug) << "Initialized " << sv.logvol->GetName()
+                         << " as sensitive detector with name '"
+                         << sv.sd_name << "'";
     }
 }
 
 //---------------------------------------------------------------------------//
 /*!
- * Find and set sensitive detectors.
+ * Sensitive volumes found when the geometry was constructed.
  */
-void DetectorConstruction::InitializeSensitiveDetectors()
+auto DetectorConstruction::SensitiveVolumes() -> VecSensitiveVolume const&
+{
+    return sensitive_volumes;
+}
+
+//---------------------------------------------------------------------------//
+// PRIVATE
+//---------------------------------------------------------------------------//
+/*!
+ * Find sensitive detectors as defined in the GDML.
+ */
+auto DetectorConstruction::FindGdmlSensitiveVolumes() const
+    -> VecSensitiveVolume
 {
-    CELER_LOG(status) << "Initializing sensitive detectors";
-    auto sd_manager = G4SDManager::GetSDMpointer();
-    CELER_ASSERT(sd_manager);
     auto const aux_map = parser_.GetAuxMap();
     CELER_ASSERT(aux_map);
 
+    VecSensitiveVolume result;
     for (auto iter = aux_map->begin(); iter != aux_map->end(); iter++)
     {
         auto const& log_vol = iter->first;
@@ -85,54 +112,38 @@ void DetectorConstruction::InitializeSensitiveDetectors()
                 // Skip non-sensitive detector auxiliary types
                 continue;
             }
-
-            // Add sensitive detector
-            std::string sd_name = element.value;
-            auto this_sd = std::make_unique<SensitiveDetector>(sd_name);
-            G4VUserDetectorConstruction::SetSensitiveDetector(
-                log_vol->GetName(), this_sd.get());
-            sd_manager->AddNewDetector(this_sd.release());
-            CELER_LOG(debug)
-                << "Inserted " << sd_name << " as sensitive detector";
+            result.push_back({log_vol, element.value});
         }
     }
+    return result;
 }
 
 //---------------------------------------------------------------------------//
 /*!
- * Set all physical volumes as sensitive detectors.
+ * Find every logical volume placed in the geometry.
  */
-void DetectorConstruction::MakeAllVolumesSensitive()
+auto DetectorConstruction::FindAllVolumes() const -> VecSensitiveVolume
 {
-    CELER_LOG_LOCAL(status)
-        << "Initializing all physical volumes as sensitive "
-           "detectors";
+    CELER_LOG(status) << "Initializing all physical volumes as sensitive "
+                         "detectors";
 
-    auto sd_manager = G4SDManager::GetSDMpointer();
-    CELER_ASSERT(sd_manager);
     auto const& physvol_store = *G4PhysicalVolumeStore::GetInstance();
     CELER_ASSERT(!physvol_store.empty());
 
+    VecSensitiveVolume result;
+    std::set<G4LogicalVolume const*> visited;
     for (auto const& physvol : physvol_store)
     {
         CELER_ASSERT(physvol);
-        auto const* logvol = physvol->GetLogicalVolume();
+        auto* logvol = physvol->GetLogicalVolume();
         CELER_ASSERT(logvol);
 
-        if (logvol->GetSensitiveDetector())
+        if (!visited.insert(logvol).second)
         {
-            // Avoid overriding existing sensitive detector object pointer
-            // This happens when logical volumes are placed multiple times
+            // Logical volumes can be placed multiple times
             continue;
         }
-
-        std::string sd_name = logvol->GetName() + "_sd";
-        auto this_sd = std::make_unique<SensitiveDetector>(sd_name);
-        G4VUserDetectorConstruction::SetSensitiveDetector(logvol->GetName(),
-                                                          this_sd.get());
-        sd_manager->AddNewDetector(this_sd.release());
-        CELER_LOG(debug) << "Initialized " << logvol->GetName()
-                         << " as sensitive detector with name '" << sd_name
-                         << "'";
+        result.push_back({logvol, logvol->GetName() + "_sd"});
     }
+    return result;
 }
@@ -7,15 +7,32 @@
 #pragma once
 
 #include <string>
+#include <vector>
 #include <G4GDMLParser.hh>
+#include <G4LogicalVolume.hh>
 #include <G4VUserDetectorConstruction.hh>
 
 //---------------------------------------------------------------------------//
 /*!
  * Construct detector geometry.
+ *
+ * Sensitive volumes are found once on the master thread when the geometry is
+ * constructed, either from the GDML \c SensDet auxiliary data or, if
+ * \c "all_volumes_sensitive" is set, from every logical volume. Worker threads
+ * attach a \c SensitiveDetector to each of them.
  */
 class DetectorConstruction final : public G4VUserDetectorConstruction
 {
+  public:
+    //! Logical volume scored by a sensitive detector
+    struct SensitiveVolume
+    {
+        G4LogicalVolume* logvol{nullptr};
+        std::string sd_name;
+    };
+
+    using VecSensitiveVolume = std::vector<SensitiveVolume>;
+
   public:
     //! Construct with GDML filename
     DetectorConstruction(std::string gdml_filename);
@@ -23,18 +40,21 @@ class DetectorConstruction final : public G4VUserDetectorConstruction
     //! Load GDML geometry
     G4VPhysicalVolume* Construct() final;
 
-    //! Sensitive detectors are the only Celeritas interface with Geant4
+    //! Attach sensitive detectors and the optional magnetic field
     void ConstructSDandField() final;
 
+    //! Sensitive volumes found when the geometry was constructed
+    static VecSensitiveVolume const& SensitiveVolumes();
+
   private:
     //// DATA ////
     G4GDMLParser parser_;
 
     //// HELPER FUNCTIONS ////
 
-    // Initialize sensitive detectors as defined in the GDML
-    void InitializeSensitiveDetectors();
+    // Find sensitive detectors as defined in the GDML
+    VecSensitiveVolume FindGdmlSensitiveVolumes() const;
 
-    // Set every physical volume as a sensitive detector
-    void MakeAllVolumesSensitive();
+    // Find every logical volume placed in the geometry
+    VecSensitiveVolume FindAllVolumes() const;
 };
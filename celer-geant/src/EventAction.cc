@@ -10,18 +10,16 @@
 #include <RootIO.hh>
 #include <corecel/io/Logger.hh>
 
-#include "JsonReader.hh"
+#include "Config.hh"
+#include "Profiler.hh"
 
 //---------------------------------------------------------------------------//
 /*!
  * Construct thread-local event action and set up event logging.
  */
-EventAction::EventAction() : G4UserEventAction()
+EventAction::EventAction()
+    : G4UserEventAction(), log_progress_(Config::Instance().log_progress)
 {
-    auto json = JsonReader::Instance();
-    log_progress_ = (json.contains("log_progress"))
-                        ? json.at("log_progress").get<size_t>()
-                        : 1;
 }
 
 //---------------------------------------------------------------------------//
@@ -30,16 +28,13 @@ EventAction::EventAction() : G4UserEventAction()
  */
 void EventAction::BeginOfEventAction(G4Event const* event)
 {
-    if (auto const id = event->GetEventID(); id % log_progress_ == 0)
+    if constexpr (Profiler::enabled())
     {
-        CELER_LOG_LOCAL(status) << "Begin event " << id;
+        Profiler::Instance().BeginEvent();
     }
-
-    // Reset energy deposition for this event
-    auto& sd_store = RootIO::Instance()->Data();
-    for (auto& [ids, data] : sd_store.Map())
+    if (auto const id = event->GetEventID(); id % log_progress_ == 0)
     {
-        data.total_edep = 0;
+        CELER_LOG_LOCAL(status) << "Begin event " << id;
     }
 }
 
@@ -49,10 +44,11 @@ void EventAction::BeginOfEventAction(G4Event const* event)
  */
 void EventAction::EndOfEventAction(G4Event const* event)
 {
-    // Fill histograms with total energy deposited in each SD
-    auto& sd_store = RootIO::Instance()->Data();
-    for (auto& [ids, data] : sd_store.Map())
+    if constexpr (Profiler::enabled())
     {
-        data.total_energy_dep.Fill(data.total_edep);
+        Profiler::Instance().EndEvent();
     }
+
+    // Fill histograms with total energy deposited in each touched SD
+    RootIO::Instance()->EndEvent(event->GetEventID());
 }
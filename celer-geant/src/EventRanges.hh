@@ -0,0 +1,169 @@
+//------------------------------- -*- C++ -*- -------------------------------//
+// Copyright Celeritas contributors: see top-level COPYRIGHT file for details
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+//---------------------------------------------------------------------------//
+//! \file celer-geant/src/EventRanges.hh
+//---------------------------------------------------------------------------//
+#pragma once
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+#include <vector>
+#include <corecel/Assert.hh>
+
+//---------------------------------------------------------------------------//
+/*!
+ * Set of event IDs stored as sorted, disjoint half-open ranges.
+ *
+ * Geant4 hands events to a worker thread in increasing order, so inserting
+ * the ID of a completed event usually extends the last range in constant
+ * time. The set of events completed by several threads is the union of
+ * their ranges, and the events left to process are the gaps in between:
+ * \code
+   EventRanges done;
+   done.Insert(0);
+   done.Insert(1);
+   done.Insert(3);
+   done.NthMissing(0);  // 2
+   done.NthMissing(1);  // 4
+   \endcode
+ */
+class EventRanges
+{
+  public:
+    //!@{
+    //! \name Type aliases
+    using size_type = size_t;
+    using Range = std::pair<size_type, size_type>;
+    using VecRange = std::vector<Range>;
+    //!@}
+
+  public:
+    //! Construct empty
+    EventRanges() = default;
+
+    // Add an event ID that is not yet in the set
+    inline void Insert(size_type id);
+
+    // Add a range of event IDs that are not yet in the set
+    inline void Insert(Range range);
+
+    // Add the events of another set, which must be disjoint
+    inline void Merge(EventRanges const& other);
+
+    // Get the n-th event ID that is not in the set
+    inline size_type NthMissing(size_type n) const;
+
+    //! Sorted, disjoint, non-adjacent half-open ranges
+    VecRange const& ranges() const { return ranges_; }
+
+    //! Number of events in the set
+    size_type size() const { return size_; }
+
+    //! Whether the set is empty
+    bool empty() const { return ranges_.empty(); }
+
+  private:
+    VecRange ranges_;
+    size_type size_{0};
+};
+
+//---------------------------------------------------------------------------//
+// INLINE DEFINITIONS
+//---------------------------------------------------------------------------//
+/*!
+ * Add an event ID that is not yet in the set.
+ */
+void EventRanges::Insert(size_type id)
+{
+    if (!ranges_.empty() && ranges_.back().second == id)
+    {
+        // Common case: next event on this thread
+        ranges_.back().second = id + 1;
+        ++size_;
+        return;
+    }
+    this->Insert(Range{id, id + 1});
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Add a range of event IDs that are not yet in the set.
+ *
+ * Adjacent ranges are coalesced.
+ */
+void EventRanges::Insert(Range range)
+{
+    CELER_EXPECT(range.first < range.second);
+
+    // First range starting after the new one
+    auto by_first = [](Range const& a, Range const& b) {
+        return a.first < b.first;
+    };
+    auto next
+        = std::upper_bound(ranges_.begin(), ranges_.end(), range, by_first);
+    CELER_VALIDATE(next == ranges_.end() || range.second <= next->first,
+                   << "event " << next->first << " was already completed");
+    if (next != ranges_.begin())
+    {
+        auto prev = std::prev(next);
+        CELER_VALIDATE(prev->second <= range.first,
+                       << "event " << range.first
+                       << " was already completed");
+        if (prev->second == range.first)
+        {
+            // Extend the previous range, then absorb the next one
+            prev->second = range.second;
+            if (next != ranges_.end() && next->first == range.second)
+            {
+                prev->second = next->second;
+                ranges_.erase(next);
+            }
+            size_ += range.second - range.first;
+            return;
+        }
+    }
+    if (next != ranges_.end() && next->first == range.second)
+    {
+        next->first = range.first;
+    }
+    else
+    {
+        ranges_.insert(next, range);
+    }
+    size_ += range.second - range.first;
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Add the events of another set, which must be disjoint from this one.
+ */
+void EventRanges::Merge(EventRanges const& other)
+{
+    for (auto const& r : other.ranges_)
+    {
+        this->Insert(r);
+    }
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Get the n-th (zero-based) event ID that is not in the set.
+ *
+ * This is linear in the number of ranges, which is at most a few per thread
+ * for the events completed by an interrupted run.
+ */
+auto EventRanges::NthMissing(size_type n) const -> size_type
+{
+    size_type result = n;
+    for (auto const& r : ranges_)
+    {
+        if (r.first > result)
+        {
+            break;
+        }
+        result += r.second - r.first;
+    }
+    return result;
+}
@@ -0,0 +1,174 @@
+//------------------------------- -*- C++ -*- -------------------------------//
+// Copyright Celeritas contributors: see top-level COPYRIGHT file for details
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+//---------------------------------------------------------------------------//
+//! \file celer-geant/src/EventWriter.cc
+//---------------------------------------------------------------------------//
+#include "EventWriter.hh"
+
+#include <memory>
+#include <TFile.h>
+#include <TTree.h>
+#include <corecel/Assert.hh>
+#include <corecel/io/Logger.hh>
+
+//---------------------------------------------------------------------------//
+/*!
+ * Construct and start the writer thread.
+ */
+EventWriter::EventWriter(std::string filename,
+                         std::vector<std::string> sd_names,
+                         std::size_t capacity)
+    : filename_(std::move(filename))
+    , sd_names_(std::move(sd_names))
+    , capacity_(capacity)
+{
+    CELER_VALIDATE(!filename_.empty(),
+                   << "event output filename must be non-empty");
+    CELER_VALIDATE(capacity_ > 0,
+                   << "event output queue capacity must be positive");
+    free_.resize(capacity_);
+    thread_ = std::thread(&EventWriter::Run, this);
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Flush remaining rows and close the file.
+ */
+EventWriter::~EventWriter()
+{
+    this->Close();
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Get an empty row to be filled.
+ *
+ * Rows already written are reused to avoid allocations.
+ */
+EventRow EventWriter::AcquireRow()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (free_.empty())
+    {
+        return {};
+    }
+    EventRow result = std::move(free_.back());
+    free_.pop_back();
+    result.clear();
+    return result;
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Queue a row for writing.
+ *
+ * This only blocks if the writer is more than \c capacity rows behind.
+ */
+void EventWriter::Push(EventRow row)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    CELER_EXPECT(!closing_);
+    cv_.wait(lock, [this] { return queue_.size() < capacity_; });
+    queue_.push_back(std::move(row));
+    lock.unlock();
+    cv_.notify_all();
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Flush remaining rows and close the file.
+ */
+void EventWriter::Close()
+{
+    if (!thread_.joinable())
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closing_ = true;
+    }
+    cv_.notify_all();
+    thread_.join();
+}
+
+//---------------------------------------------------------------------------//
+// PRIVATE
+//---------------------------------------------------------------------------//
+/*!
+ * Background thread loop.
+ *
+ * The ROOT file and trees are only accessed from this thread.
+ */
+void EventWriter::Run()
+{
+    std::unique_ptr<TFile> file(TFile::Open(filename_.c_str(), "recreate"));
+    if (!file || file->IsZombie())
+    {
+        CELER_LOG(error) << "Failed to open event output file \""
+                         << filename_ << "\": events will not be written";
+        file.reset();
+    }
+
+    // Map SD indices to names
+    std::unique_ptr<TTree> events;
+    EventRow current;
+    if (file)
+    {
+        TTree sds("sensitive_detectors", "sensitive_detectors");
+        std::uint32_t sd_index{};
+        std::string sd_name;
+        sds.Branch("sd_index", &sd_index);
+        sds.Branch("sd_name", &sd_name);
+        for (std::size_t i = 0; i < sd_names_.size(); ++i)
+        {
+            sd_index = i;
+            sd_name = sd_names_[i];
+            sds.Fill();
+        }
+        sds.Write();
+
+        events = std::make_unique<TTree>("events", "events");
+        events->Branch("event_id", &current.event_id);
+        events->Branch("sd_index", &current.sd_index);
+        events->Branch("edep", &current.edep);
+        events->Branch("num_steps", &current.num_steps);
+    }
+
+    std::size_t num_rows = 0;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true)
+    {
+        cv_.wait(lock, [this] { return closing_ || !queue_.empty(); });
+        if (queue_.empty())
+        {
+            // Closing and every row is written
+            break;
+        }
+
+        // Write a row without holding the lock
+        std::swap(current, queue_.front());
+        queue_.pop_front();
+        lock.unlock();
+        cv_.notify_all();
+        if (events)
+        {
+            events->Fill();
+            ++num_rows;
+        }
+        lock.lock();
+        free_.push_back(std::move(current));
+        current = {};
+    }
+    lock.unlock();
+
+    if (file)
+    {
+        events->Write();
+        events.reset();
+        file->Close();
+        CELER_LOG(info) << "Wrote " << num_rows << " events to \""
+                        << filename_ << "\"";
+    }
+}
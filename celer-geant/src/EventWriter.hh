@@ -0,0 +1,97 @@
+//------------------------------- -*- C++ -*- -------------------------------//
+// Copyright Celeritas contributors: see top-level COPYRIGHT file for details
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+//---------------------------------------------------------------------------//
+//! \file celer-geant/src/EventWriter.hh
+//---------------------------------------------------------------------------//
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+//---------------------------------------------------------------------------//
+/*!
+ * Per-event summary of the sensitive detectors touched in an event.
+ *
+ * The three vectors have one entry per touched SD, where \c sd_index is the
+ * index of the SD in \c RootDataStore::SensDets .
+ */
+struct EventRow
+{
+    std::int32_t event_id{-1};
+    std::vector<std::uint32_t> sd_index;
+    std::vector<double> edep;  //!< Total energy deposition [MeV]
+    std::vector<std::uint32_t> num_steps;
+
+    //! Remove all entries, keeping the allocated capacity
+    void clear()
+    {
+        event_id = -1;
+        sd_index.clear();
+        edep.clear();
+        num_steps.clear();
+    }
+};
+
+//---------------------------------------------------------------------------//
+/*!
+ * Asynchronous per-event TTree writer owned by a worker thread.
+ *
+ * Rows are pushed into a bounded queue and written by a background thread,
+ * which owns the ROOT file, so compression and disk I/O happen off the
+ * tracking thread. Each worker writes its own file, with the thread ID
+ * appended to the filename. Written rows are recycled so that filling an
+ * event does not allocate in steady state.
+ *
+ * The file contains an \c "events" tree with one row per event and an
+ * \c "sensitive_detectors" tree mapping \c sd_index to the SD name.
+ *
+ * If the writer falls more than \c capacity rows behind, \c Push blocks
+ * until a row has been written.
+ */
+class EventWriter
+{
+  public:
+    // Construct and start the writer thread
+    EventWriter(std::string filename,
+                std::vector<std::string> sd_names,
+                std::size_t capacity);
+
+    // Flush remaining rows and close the file
+    ~EventWriter();
+
+    //!@{
+    //! Prevent copying and moving
+    EventWriter(EventWriter const&) = delete;
+    EventWriter& operator=(EventWriter const&) = delete;
+    //!@}
+
+    // Get an empty row to be filled
+    EventRow AcquireRow();
+
+    // Queue a row for writing
+    void Push(EventRow row);
+
+    // Flush remaining rows and close the file
+    void Close();
+
+  private:
+    std::string filename_;
+    std::vector<std::string> sd_names_;
+    std::size_t capacity_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<EventRow> queue_;
+    std::vector<EventRow> free_;
+    bool closing_{false};
+    std::thread thread_;
+
+    // Background thread loop
+    void Run();
+};
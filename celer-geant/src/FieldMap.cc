@@ -0,0 +1,87 @@
+//------------------------------- -*- C++ -*- -------------------------------//
+// Copyright Celeritas contributors: see top-level COPYRIGHT file for details
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+//---------------------------------------------------------------------------//
+//! \file celer-geant/src/FieldMap.cc
+//---------------------------------------------------------------------------//
+#include "FieldMap.hh"
+
+#include <fstream>
+#include <sstream>
+#include <corecel/Assert.hh>
+#include <corecel/io/Logger.hh>
+
+namespace
+{
+//---------------------------------------------------------------------------//
+/*!
+ * Stream the values of a text file with \c # comments removed.
+ */
+std::istringstream strip_comments(std::ifstream& is)
+{
+    std::string result;
+    std::string line;
+    while (std::getline(is, line))
+    {
+        result += line.substr(0, line.find('#'));
+        result += '\n';
+    }
+    return std::istringstream(result);
+}
+
+//---------------------------------------------------------------------------//
+}  // namespace
+
+//---------------------------------------------------------------------------//
+/*!
+ * Read from a text file.
+ */
+FieldMap FieldMap::Read(std::string const& filename)
+{
+    std::ifstream file(filename);
+    CELER_VALIDATE(file, << "failed to open field map \"" << filename << "\"");
+    auto is = strip_comments(file);
+
+    FieldMap result;
+    std::string geometry;
+    is >> geometry;
+    CELER_VALIDATE(geometry == "rz",
+                   << "field map \"" << filename
+                   << "\" must start with \"rz\" (only RZ maps are "
+                      "supported)");
+
+    for (auto& axis : result.axes_)
+    {
+        is >> axis.size;
+    }
+    std::size_t num_nodes = 1;
+    for (std::size_t i = 0; i < result.axes_.size(); ++i)
+    {
+        auto& axis = result.axes_[i];
+        is >> axis.min >> axis.max;
+        CELER_VALIDATE(is && axis.size >= 2 && axis.max > axis.min,
+                       << "invalid grid axis " << i << " in field map \""
+                       << filename << "\"");
+        axis.inv_delta = (axis.size - 1) / (axis.max - axis.min);
+        num_nodes *= axis.size;
+    }
+    CELER_VALIDATE(result.axes_[0].min >= 0,
+                   << "negative radius in field map \"" << filename << "\"");
+
+    result.nodes_.resize(num_nodes);
+    for (auto& node : result.nodes_)
+    {
+        is >> node.r >> node.z;
+    }
+    CELER_VALIDATE(is,
+                   << "field map \"" << filename << "\" has fewer than "
+                   << num_nodes << " nodes");
+    double extra;
+    CELER_VALIDATE(!(is >> extra),
+                   << "field map \"" << filename << "\" has more than "
+                   << num_nodes << " nodes");
+
+    CELER_LOG(info) << "Loaded RZ field map \"" << filename << "\" with "
+                    << num_nodes << " nodes";
+    return result;
+}
@@ -0,0 +1,135 @@
+//------------------------------- -*- C++ -*- -------------------------------//
+// Copyright Celeritas contributors: see top-level COPYRIGHT file for details
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+//---------------------------------------------------------------------------//
+//! \file celer-geant/src/FieldMap.hh
+//---------------------------------------------------------------------------//
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <string>
+#include <vector>
+
+//---------------------------------------------------------------------------//
+/*!
+ * Axisymmetric magnetic field tabulated on a regular (r, z) grid.
+ *
+ * The radial and axial field are interpolated bilinearly. Positions are in
+ * cm and the field is in tesla; outside the grid the field is zero. This is
+ * the layout of the Celeritas RZ map field, which is built from the same
+ * grid.
+ *
+ * The map is read once from a text file and shared read-only by every
+ * thread. Each node holds its two field components aligned to 16 bytes, so a
+ * node never straddles a cache line and interpolation touches at most four
+ * lines.
+ *
+ * File format (\c # starts a comment):
+ * \verbatim
+   rz [nr] [nz] [rmin] [rmax] [zmin] [zmax]
+   [br] [bz]        // nr * nz lines, r fastest, then z
+   \endverbatim
+ */
+class FieldMap
+{
+  public:
+    //! Regularly spaced grid axis [cm]
+    struct Axis
+    {
+        double min{0};
+        double max{0};
+        std::size_t size{0};
+        double inv_delta{0};
+    };
+
+    //! Field at a grid node [T], aligned to avoid straddling cache lines
+    struct alignas(16) Node
+    {
+        double r{0};
+        double z{0};
+    };
+
+    using VecNode = std::vector<Node>;
+
+  public:
+    // Read from a text file
+    static FieldMap Read(std::string const& filename);
+
+    //! Evaluate the field [T] at a position [cm]
+    inline std::array<double, 3>
+    operator()(double x, double y, double z) const;
+
+    //! r and z axes
+    Axis const& axis(std::size_t i) const { return axes_[i]; }
+
+    //! Field nodes, z-major with r varying fastest
+    VecNode const& nodes() const { return nodes_; }
+
+  private:
+    //// DATA ////
+
+    std::array<Axis, 2> axes_;
+    VecNode nodes_;
+
+    //// HELPER FUNCTIONS ////
+
+    // Find the lower node and fraction along an axis
+    static inline bool
+    Locate(Axis const& axis, double x, std::size_t* i, double* t);
+};
+
+//---------------------------------------------------------------------------//
+// INLINE DEFINITIONS
+//---------------------------------------------------------------------------//
+/*!
+ * Evaluate the field [T] at a position [cm].
+ */
+std::array<double, 3> FieldMap::operator()(double x, double y, double z) const
+{
+    std::array<double, 3> result{0, 0, 0};
+    std::size_t i[2];
+    double t[2];
+
+    double const r = std::sqrt(x * x + y * y);
+    if (!Locate(axes_[0], r, &i[0], &t[0])
+        || !Locate(axes_[1], z, &i[1], &t[1]))
+    {
+        return result;
+    }
+
+    auto lerp = [](Node const& a, Node const& b, double f) {
+        return Node{a.r + f * (b.r - a.r), a.z + f * (b.z - a.z)};
+    };
+    std::size_t const nr = axes_[0].size;
+    Node const* n = nodes_.data() + i[1] * nr + i[0];
+    Node const b = lerp(
+        lerp(n[0], n[1], t[0]), lerp(n[nr], n[nr + 1], t[0]), t[1]);
+    // Rotate the radial component into x and y
+    if (r > 0)
+    {
+        result[0] = b.r * x / r;
+        result[1] = b.r * y / r;
+    }
+    result[2] = b.z;
+    return result;
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Find the lower node and fraction along an axis.
+ *
+ * The lower node is clamped so that the upper edge of the grid is included.
+ */
+bool FieldMap::Locate(Axis const& axis, double x, std::size_t* i, double* t)
+{
+    if (!(x >= axis.min && x <= axis.max))
+    {
+        return false;
+    }
+    double const u = (x - axis.min) * axis.inv_delta;
+    double const lower = std::fmin(std::floor(u), double(axis.size - 2));
+    *i = static_cast<std::size_t>(lower);
+    *t = u - lower;
+    return true;
+}
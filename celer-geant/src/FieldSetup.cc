@@ -0,0 +1,196 @@
+//------------------------------- -*- C++ -*- -------------------------------//
+// Copyright Celeritas contributors: see top-level COPYRIGHT file for details
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+//---------------------------------------------------------------------------//
+//! \file celer-geant/src/FieldSetup.cc
+//---------------------------------------------------------------------------//
+#include "FieldSetup.hh"
+
+#include <array>
+#include <mutex>
+#include <G4AutoDelete.hh>
+#include <G4FieldManager.hh>
+#include <G4MagneticField.hh>
+#include <G4SystemOfUnits.hh>
+#include <G4TransportationManager.hh>
+#include <G4UniformMagField.hh>
+#include <accel/AlongStepFactory.hh>
+#include <celeritas/Units.hh>
+#include <celeritas/field/RZMapFieldInput.hh>
+#include <corecel/Assert.hh>
+#include <corecel/io/Logger.hh>
+
+#include "JsonReader.hh"
+
+namespace
+{
+//---------------------------------------------------------------------------//
+//! Field map shared by all threads.
+FieldMap field_map;
+std::once_flag field_map_loaded;
+
+//---------------------------------------------------------------------------//
+/*!
+ * Geant4 field interpolated from the shared field map.
+ */
+class FieldMapMagField final : public G4MagneticField
+{
+  public:
+    explicit FieldMapMagField(FieldMap const& map) : map_(map) {}
+
+    void GetFieldValue(G4double const point[4], G4double* field) const final
+    {
+        auto const b = map_(point[0] / cm, point[1] / cm, point[2] / cm);
+        for (int i = 0; i < 3; ++i)
+        {
+            field[i] = b[i] * tesla;
+        }
+    }
+
+  private:
+    FieldMap const& map_;
+};
+
+//---------------------------------------------------------------------------//
+/*!
+ * Validated \c "field" JSON block.
+ */
+nlohmann::json const& field_input()
+{
+    auto const& json = JsonReader::Instance().at("field");
+    CELER_VALIDATE(json.contains("uniform") != json.contains("map"),
+                   << "\"field\" must have exactly one of \"uniform\" or "
+                      "\"map\"");
+    return json;
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Uniform field [T].
+ */
+std::array<double, 3> uniform_field()
+{
+    return field_input().at("uniform").get<std::array<double, 3>>();
+}
+
+//---------------------------------------------------------------------------//
+}  // namespace
+
+//---------------------------------------------------------------------------//
+/*!
+ * Whether a field is present in the JSON input.
+ */
+bool FieldSetup::Enabled()
+{
+    return JsonReader::Instance().contains("field");
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Field map shared by all threads, loaded on first use.
+ */
+FieldMap const& FieldSetup::Map()
+{
+    CELER_EXPECT(FieldSetup::Enabled());
+    std::call_once(field_map_loaded, [] {
+        auto const& json = field_input();
+        JsonReader::Validate(json, "map");
+        auto const filename = json.at("map").get<std::string>();
+        field_map = FieldMap::Read(filename);
+    });
+    return field_map;
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Attach the field to the Geant4 field manager of this thread.
+ *
+ * The field is deleted by Geant4 at the end of the thread.
+ */
+void FieldSetup::ConstructField()
+{
+    if (!FieldSetup::Enabled())
+    {
+        return;
+    }
+
+    G4MagneticField* field = nullptr;
+    if (field_input().contains("uniform"))
+    {
+        auto const b = uniform_field();
+        field = new G4UniformMagField(G4ThreeVector(b[0], b[1], b[2])
+                                      * tesla);
+    }
+    else
+    {
+        field = new FieldMapMagField(FieldSetup::Map());
+    }
+    G4AutoDelete::Register(field);
+
+    auto* field_manager = G4TransportationManager::GetTransportationManager()
+                              ->GetFieldManager();
+    CELER_ASSERT(field_manager);
+    field_manager->SetDetectorField(field);
+    field_manager->CreateChordFinder(field);
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Celeritas along-step action with the field.
+ *
+ * This is called while the input is processed, before Geant4 is initialized,
+ * so a field map is read and validated here. Celeritas interpolates the RZ
+ * map from the same grid when it is set up.
+ */
+celeritas::SetupOptions::AlongStepFactory FieldSetup::MakeAlongStep()
+{
+    using celeritas::units::centimeter;
+    using celeritas::units::tesla;
+
+    if (!FieldSetup::Enabled())
+    {
+        return celeritas::UniformAlongStepFactory();
+    }
+
+    if (field_input().contains("uniform"))
+    {
+        return celeritas::UniformAlongStepFactory([] {
+            auto const b = uniform_field();
+            celeritas::Real3 result;
+            for (int i = 0; i < 3; ++i)
+            {
+                result[i] = b[i] * static_cast<double>(tesla);
+            }
+            return result;
+        });
+    }
+
+    // Fail before any Geant4 or Celeritas setup if the map is invalid
+    FieldSetup::Map();
+
+    return celeritas::RZMapFieldAlongStepFactory([] {
+        auto const& map = FieldSetup::Map();
+        auto const& r = map.axis(0);
+        auto const& z = map.axis(1);
+        auto const cm = static_cast<double>(centimeter);
+        auto const t = static_cast<double>(tesla);
+
+        celeritas::RZMapFieldInput result;
+        result.num_grid_r = r.size;
+        result.num_grid_z = z.size;
+        result.min_r = r.min * cm;
+        result.max_r = r.max * cm;
+        result.min_z = z.min * cm;
+        result.max_z = z.max * cm;
+        // Both layouts are z-major with r varying fastest
+        result.field_r.reserve(map.nodes().size());
+        result.field_z.reserve(map.nodes().size());
+        for (auto const& node : map.nodes())
+        {
+            result.field_r.push_back(node.r * t);
+            result.field_z.push_back(node.z * t);
+        }
+        CELER_LOG(info) << "Using RZ field map for Celeritas tracking";
+        return result;
+    });
+}
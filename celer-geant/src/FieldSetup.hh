@@ -0,0 +1,43 @@
+//------------------------------- -*- C++ -*- -------------------------------//
+// Copyright Celeritas contributors: see top-level COPYRIGHT file for details
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+//---------------------------------------------------------------------------//
+//! \file celer-geant/src/FieldSetup.hh
+//---------------------------------------------------------------------------//
+#pragma once
+
+#include <accel/SetupOptions.hh>
+
+#include "FieldMap.hh"
+
+//---------------------------------------------------------------------------//
+/*!
+ * Magnetic field shared by Geant4 and Celeritas tracking.
+ *
+ * The optional \c "field" JSON block is either a uniform field [T] or a
+ * \c FieldMap file:
+ * \code
+   "field": {"uniform": [0, 0, 3.8]}
+   "field": {"map": "solenoid-rz.txt"}
+   \endcode
+ *
+ * The map is loaded once, while the Celeritas options are built on the
+ * master thread, and shared read-only by the Geant4 field of every worker
+ * thread. Celeritas builds its RZ map field from the same grid. Without a
+ * \c "field" block, the field is zero.
+ */
+class FieldSetup
+{
+  public:
+    // Whether a field is present in the JSON input
+    static bool Enabled();
+
+    // Field map shared by all threads, loaded on first use
+    static FieldMap const& Map();
+
+    // Attach the field to the Geant4 field manager of this thread
+    static void ConstructField();
+
+    // Celeritas along-step action with the field
+    static celeritas::SetupOptions::AlongStepFactory MakeAlongStep();
+};
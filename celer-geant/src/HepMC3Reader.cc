@@ -0,0 +1,258 @@
+//------------------------------- -*- C++ -*- -------------------------------//
+// Copyright Celeritas contributors: see top-level COPYRIGHT file for details
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+//---------------------------------------------------------------------------//
+//! \file celer-geant/src/HepMC3Reader.cc
+//---------------------------------------------------------------------------//
+#include "HepMC3Reader.hh"
+
+#include <unordered_map>
+#include <G4PhysicalConstants.hh>
+#include <G4PrimaryParticle.hh>
+#include <G4PrimaryVertex.hh>
+#include <HepMC3/GenEvent.h>
+#include <HepMC3/GenParticle.h>
+#include <HepMC3/GenVertex.h>
+#include <HepMC3/ReaderFactory.h>
+#include <corecel/Assert.hh>
+#include <corecel/io/Logger.hh>
+
+#include "Config.hh"
+#include "JsonReader.hh"
+#include "RootIO.hh"
+
+namespace
+{
+//---------------------------------------------------------------------------//
+/*!
+ * Group the final-state particles of a record by production vertex.
+ */
+HepMC3Reader::VecVertex decode(HepMC3::GenEvent& record)
+{
+    record.set_units(HepMC3::Units::MEV, HepMC3::Units::MM);
+
+    HepMC3Reader::VecVertex result;
+    std::unordered_map<int, std::size_t> vertex_index;
+    for (auto const& particle : record.particles())
+    {
+        if (particle->status() != 1)
+        {
+            // Only final-state particles are primaries
+            continue;
+        }
+        auto const vertex = particle->production_vertex();
+        int const id = vertex ? vertex->id() : 0;
+        auto [iter, inserted] = vertex_index.insert({id, result.size()});
+        if (inserted)
+        {
+            auto const& pos = vertex ? vertex->position() : record.event_pos();
+            result.push_back({G4ThreeVector(pos.x(), pos.y(), pos.z()),
+                              pos.t() / CLHEP::c_light,
+                              {}});
+        }
+        auto const& mom = particle->momentum();
+        result[iter->second].primaries.push_back(
+            {particle->pid(), G4ThreeVector(mom.px(), mom.py(), mom.pz())});
+    }
+    return result;
+}
+
+//---------------------------------------------------------------------------//
+}  // namespace
+
+//---------------------------------------------------------------------------//
+/*!
+ * Whether HepMC3 input is present in the JSON input.
+ */
+bool HepMC3Reader::Enabled()
+{
+    return JsonReader::Instance().contains("hepmc3");
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Reader shared by all threads, started on first use.
+ *
+ * This is first called by a worker thread during the event loop, after the
+ * events of a resumed run are known.
+ */
+HepMC3Reader& HepMC3Reader::Instance()
+{
+    static auto const reader = [] {
+        CELER_EXPECT(HepMC3Reader::Enabled());
+        auto const& json = JsonReader::Instance();
+        auto const& input = json.at("hepmc3");
+        JsonReader::Validate(input, "filename");
+        auto const capacity = input.contains("prefetch")
+                                  ? input.at("prefetch").get<std::size_t>()
+                                  : std::size_t{64};
+        CELER_VALIDATE(capacity > 0,
+                       << "HepMC3 \"prefetch\" must be positive");
+
+        auto const& resumed = RootIO::ResumedEvents();
+        auto const num_events = Config::Instance().num_events
+                                - resumed.size();
+        return std::make_unique<HepMC3Reader>(
+            input.at("filename").get<std::string>(),
+            capacity,
+            num_events,
+            resumed);
+    }();
+    return *reader;
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Construct and start the reader thread.
+ *
+ * \c num_events records are read, skipping the records whose index is in
+ * \c skipped .
+ */
+HepMC3Reader::HepMC3Reader(std::string const& filename,
+                           std::size_t capacity,
+                           std::size_t num_events,
+                           EventRanges skipped)
+    : slots_(capacity), num_events_(num_events), skipped_(std::move(skipped))
+{
+    CELER_EXPECT(capacity > 0);
+    CELER_LOG(info) << "Reading " << num_events << " HepMC3 events from \""
+                    << filename << "\" with " << capacity
+                    << " prefetched events";
+    thread_ = std::thread(&HepMC3Reader::Run, this, filename);
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Stop the reader thread.
+ */
+HepMC3Reader::~HepMC3Reader()
+{
+    stop_ = true;
+    this->NotifyAll();
+    thread_.join();
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Add the primaries of the given event sequence number to an event.
+ *
+ * The sequence number is the Geant4 event ID before any relabeling of a
+ * resumed run. This blocks until the reader has decoded the event.
+ */
+void HepMC3Reader::GeneratePrimaryVertex(std::size_t sequence,
+                                         G4Event* event)
+{
+    CELER_EXPECT(event);
+    CELER_VALIDATE(sequence < num_events_,
+                   << "HepMC3 event " << sequence << " exceeds the "
+                   << num_events_ << " events to be read");
+
+    auto& slot = slots_[sequence % slots_.size()];
+    VecVertex vertices;
+    {
+        std::unique_lock lock(slot.mutex);
+        slot.cv.wait(lock, [&] {
+            return (slot.full && slot.sequence == sequence) || done_;
+        });
+        CELER_VALIDATE(slot.full && slot.sequence == sequence,
+                       << "HepMC3 event " << sequence
+                       << " could not be read: " << error_);
+        vertices = std::move(slot.vertices);
+        slot.full = false;
+    }
+    // Let the reader refill the slot
+    slot.cv.notify_all();
+
+    for (auto const& v : vertices)
+    {
+        auto* vertex = new G4PrimaryVertex(v.position, v.time);
+        for (auto const& p : v.primaries)
+        {
+            vertex->SetPrimary(new G4PrimaryParticle(
+                p.pdg, p.momentum.x(), p.momentum.y(), p.momentum.z()));
+        }
+        event->AddPrimaryVertex(vertex);
+    }
+}
+
+//---------------------------------------------------------------------------//
+// PRIVATE
+//---------------------------------------------------------------------------//
+/*!
+ * Decode records into the ring until all events are read.
+ *
+ * Errors cannot be thrown from this thread: they are stored and raised by
+ * the worker waiting for the missing event.
+ */
+void HepMC3Reader::Run(std::string filename)
+{
+    auto reader = HepMC3::deduce_reader(filename);
+    if (!reader || reader->failed())
+    {
+        error_ = "failed to open \"" + filename + "\"";
+    }
+
+    HepMC3::GenEvent record;
+    std::size_t index = 0;
+    for (std::size_t seq = 0; error_.empty() && seq < num_events_ && !stop_;
+         ++seq)
+    {
+        // Skip records of events completed before a restart
+        auto const target = skipped_.NthMissing(seq);
+        if (target > index
+            && !reader->skip(static_cast<int>(target - index)))
+        {
+            error_ = "\"" + filename + "\" has fewer than "
+                     + std::to_string(target) + " records";
+            break;
+        }
+        index = target;
+        if (!reader->read_event(record) || reader->failed())
+        {
+            error_ = "\"" + filename + "\" has only "
+                     + std::to_string(index) + " records";
+            break;
+        }
+        ++index;
+        auto vertices = decode(record);
+
+        auto& slot = slots_[seq % slots_.size()];
+        {
+            std::unique_lock lock(slot.mutex);
+            slot.cv.wait(lock, [&] { return !slot.full || stop_; });
+            if (stop_)
+            {
+                break;
+            }
+            slot.vertices = std::move(vertices);
+            slot.sequence = seq;
+            slot.full = true;
+        }
+        slot.cv.notify_all();
+    }
+    if (reader)
+    {
+        reader->close();
+    }
+
+    done_ = true;
+    this->NotifyAll();
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Wake every waiting worker.
+ *
+ * Each slot is locked so that a worker cannot miss the notification between
+ * checking its condition and waiting.
+ */
+void HepMC3Reader::NotifyAll()
+{
+    for (auto& slot : slots_)
+    {
+        {
+            std::lock_guard lock(slot.mutex);
+        }
+        slot.cv.notify_all();
+    }
+}
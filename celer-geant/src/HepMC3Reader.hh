@@ -0,0 +1,114 @@
+//------------------------------- -*- C++ -*- -------------------------------//
+// Copyright Celeritas contributors: see top-level COPYRIGHT file for details
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+//---------------------------------------------------------------------------//
+//! \file celer-geant/src/HepMC3Reader.hh
+//---------------------------------------------------------------------------//
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <G4Event.hh>
+#include <G4ThreeVector.hh>
+
+#include "EventRanges.hh"
+
+//---------------------------------------------------------------------------//
+/*!
+ * Prefetching HepMC3 event reader shared by all worker threads.
+ *
+ * The optional \c "hepmc3" JSON block replaces the particle gun:
+ * \code
+   "hepmc3": {"filename": "events.hepmc3", "prefetch": 64}
+   \endcode
+ * Any format deduced by the HepMC3 reader factory (HepMC3, HepMC2, HEPEVT,
+ * ...) can be read. The \c "particle_gun" block then only needs
+ * \c "num_events" .
+ *
+ * A single background thread decodes the final-state particles of each
+ * record into a ring of \c "prefetch" slots. The slot of an event is chosen
+ * by its Geant4 event ID, so each worker waits only on its own slot, and
+ * event \em i of a run is always record \em i of the file regardless of
+ * which thread processes it. Records of events completed before a resumed
+ * run (see \c RootIO::Resume ) are skipped.
+ */
+class HepMC3Reader
+{
+  public:
+    //! Final-state particle of a record
+    struct Primary
+    {
+        int pdg{0};
+        G4ThreeVector momentum;  //!< [MeV]
+    };
+
+    //! Production vertex of final-state particles
+    struct Vertex
+    {
+        G4ThreeVector position;  //!< [mm]
+        double time{0};  //!< [ns]
+        std::vector<Primary> primaries;
+    };
+
+    using VecVertex = std::vector<Vertex>;
+
+  public:
+    // Whether HepMC3 input is present in the JSON input
+    static bool Enabled();
+
+    // Reader shared by all threads, started on first use
+    static HepMC3Reader& Instance();
+
+    // Construct and start the reader thread
+    HepMC3Reader(std::string const& filename,
+                 std::size_t capacity,
+                 std::size_t num_events,
+                 EventRanges skipped);
+
+    // Stop the reader thread
+    ~HepMC3Reader();
+
+    //!@{
+    //! Prevent copying and moving
+    HepMC3Reader(HepMC3Reader const&) = delete;
+    HepMC3Reader& operator=(HepMC3Reader const&) = delete;
+    //!@}
+
+    // Add the primaries of the given event sequence number to an event
+    void GeneratePrimaryVertex(std::size_t sequence, G4Event* event);
+
+  private:
+    //// TYPES ////
+
+    struct Slot
+    {
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::size_t sequence{0};
+        bool full{false};
+        VecVertex vertices;
+    };
+
+    //// DATA ////
+
+    std::vector<Slot> slots_;
+    std::size_t num_events_;
+    EventRanges skipped_;
+    std::atomic<bool> stop_{false};
+    std::atomic<bool> done_{false};
+    std::string error_;  //!< Set by the reader thread before \c done_
+    std::thread thread_;
+
+    //// HELPER FUNCTIONS ////
+
+    // Decode records into the ring until all events are read
+    void Run(std::string filename);
+
+    // Wake every waiting worker
+    void NotifyAll();
+};
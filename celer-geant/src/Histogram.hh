@@ -0,0 +1,502 @@
+//------------------------------- -*- C++ -*- -------------------------------//
+// Copyright Celeritas contributors: see top-level COPYRIGHT file for details
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+//---------------------------------------------------------------------------//
+//! \file celer-geant/src/Histogram.hh
+//---------------------------------------------------------------------------//
+#pragma once
+
+#include <algorithm>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <corecel/Assert.hh>
+
+//---------------------------------------------------------------------------//
+/*!
+ * Histogram axis with uniform or variable binning.
+ *
+ * Bin numbering follows the ROOT convention: bin 0 is the underflow, bins
+ * \c [1, num_bins] are the regular bins, and bin \c num_bins+1 is the
+ * overflow. Uniform axes precompute the inverse bin width so that finding a
+ * bin is a multiplication; variable axes use a binary search over the edges.
+ */
+class HistogramAxis
+{
+  public:
+    //!@{
+    //! \name Type aliases
+    using size_type = size_t;
+    using VecDbl = std::vector<double>;
+    //!@}
+
+  public:
+    //! Construct empty
+    HistogramAxis() = default;
+
+    // Construct with uniform binning
+    inline HistogramAxis(size_type num_bins, double min, double max);
+
+    // Construct with variable binning from bin edges
+    inline explicit HistogramAxis(VecDbl edges);
+
+    // Find bin index, including underflow and overflow
+    inline size_type FindBin(double x) const;
+
+    //! Number of regular bins
+    size_type num_bins() const { return num_bins_; }
+
+    //! Number of bins including underflow and overflow
+    size_type size() const { return num_bins_ + 2; }
+
+    //! Lower edge of the axis
+    double min() const { return min_; }
+
+    //! Upper edge of the axis
+    double max() const { return max_; }
+
+    //! Whether bins have a constant width
+    bool is_uniform() const { return edges_.empty(); }
+
+    //! Bin edges for variable binning (empty if uniform)
+    VecDbl const& edges() const { return edges_; }
+
+    // Bin edges, generated if the axis is uniform
+    inline VecDbl MakeEdges() const;
+
+    // Whether two axes have the same binning
+    inline bool operator==(HistogramAxis const& other) const;
+
+  private:
+    size_type num_bins_{0};
+    double min_{0};
+    double max_{0};
+    double inv_width_{0};
+    VecDbl edges_;
+};
+
+//---------------------------------------------------------------------------//
+/*!
+ * Per-event sums of weights and of their squares for a single bin.
+ *
+ * Fills during an event only add to \c event_w ; at the end of the event the
+ * partial sum is folded into \c sum_w and its square into \c sum_w2 . The
+ * bin error is therefore derived from the event-to-event variance rather
+ * than from the step weights, which are correlated within an event. All
+ * values are stored together so that a fill touches a single cache line.
+ */
+struct HistogramBin
+{
+    double sum_w{0};
+    double sum_w2{0};
+    double event_w{0};  //!< Partial sum of the current event
+    bool pending{false};  //!< Whether the bin was filled in this event
+
+    //! Accumulate another bin
+    HistogramBin& operator+=(HistogramBin const& other)
+    {
+        CELER_EXPECT(!other.pending);
+        sum_w += other.sum_w;
+        sum_w2 += other.sum_w2;
+        return *this;
+    }
+
+    //! Fold the partial sum of the current event
+    void EndEvent()
+    {
+        sum_w += event_w;
+        sum_w2 += event_w * event_w;
+        event_w = 0;
+        pending = false;
+    }
+};
+
+//---------------------------------------------------------------------------//
+/*!
+ * Lightweight one-dimensional histogram.
+ *
+ * Bins are stored contiguously, including underflow and overflow, and are
+ * converted to a ROOT \c TH1D only when written to disk.
+ */
+class Histogram1D
+{
+  public:
+    //!@{
+    //! \name Type aliases
+    using size_type = size_t;
+    using VecBin = std::vector<HistogramBin>;
+    //!@}
+
+  public:
+    //! Construct empty
+    Histogram1D() = default;
+
+    //! Construct with axis binning
+    explicit Histogram1D(HistogramAxis x) : x_(std::move(x)), bins_(x_.size())
+    {
+    }
+
+    //! Add a weighted entry to the current event
+    void Fill(double x, double weight = 1)
+    {
+        auto const i = x_.FindBin(x);
+        auto& bin = bins_[i];
+        if (!bin.pending)
+        {
+            bin.pending = true;
+            pending_.push_back(i);
+        }
+        bin.event_w += weight;
+        ++num_entries_;
+    }
+
+    //! Add several complete events with one unit-weight entry each
+    void FillN(double x, size_type count)
+    {
+        auto& bin = bins_[x_.FindBin(x)];
+        bin.sum_w += count;
+        bin.sum_w2 += count;
+        num_entries_ += count;
+    }
+
+    //! Fold the bins filled in the current event
+    void EndEvent()
+    {
+        for (auto i : pending_)
+        {
+            bins_[i].EndEvent();
+        }
+        pending_.clear();
+    }
+
+    // Add the contents of a histogram with identical binning
+    inline void Merge(Histogram1D const& other);
+
+    //! Accumulate saved bin contents, e.g. from a checkpoint
+    void AddBin(size_type index, HistogramBin const& bin)
+    {
+        CELER_EXPECT(index < bins_.size());
+        bins_[index] += bin;
+    }
+
+    //! Accumulate a saved number of fills
+    void AddEntries(size_type count) { num_entries_ += count; }
+
+    //! Call a function with the index and contents of every bin
+    template<class F>
+    void ForEachBin(F&& func) const
+    {
+        for (size_type i = 0; i < bins_.size(); ++i)
+        {
+            func(i, bins_[i]);
+        }
+    }
+
+    //! Axis binning
+    HistogramAxis const& axis() const { return x_; }
+
+    //! Bins, including underflow and overflow
+    VecBin const& bins() const { return bins_; }
+
+    //! Number of fills
+    size_type num_entries() const { return num_entries_; }
+
+  private:
+    HistogramAxis x_;
+    VecBin bins_;
+    std::vector<size_type> pending_;
+    size_type num_entries_{0};
+};
+
+//---------------------------------------------------------------------------//
+/*!
+ * Lightweight two-dimensional histogram with sparse storage.
+ *
+ * Global bin indices follow ROOT's numbering with the x index varying
+ * fastest: \c bin = \c ix + \c (nx+2) * \c iy . Bins are stored in a hash
+ * map until more than a quarter of the cells are occupied, at which point
+ * the histogram switches to a contiguous dense array. Histograms of rarely
+ * hit volumes therefore only cost memory proportional to their activity.
+ */
+class Histogram2D
+{
+  public:
+    //!@{
+    //! \name Type aliases
+    using size_type = size_t;
+    using VecBin = std::vector<HistogramBin>;
+    using MapBin = std::unordered_map<size_type, HistogramBin>;
+    //!@}
+
+  public:
+    //! Construct empty
+    Histogram2D() = default;
+
+    //! Construct with axes binning, without allocating bins
+    Histogram2D(HistogramAxis x, HistogramAxis y)
+        : x_(std::move(x)), y_(std::move(y))
+    {
+    }
+
+    //! Add a weighted entry to the current event
+    void Fill(double x, double y, double weight = 1)
+    {
+        auto const i = x_.FindBin(x) + x_.size() * y_.FindBin(y);
+        auto& bin = this->Bin(i);
+        if (!bin.pending)
+        {
+            bin.pending = true;
+            pending_.push_back(i);
+        }
+        bin.event_w += weight;
+        ++num_entries_;
+    }
+
+    //! Add several complete events with one unit-weight entry each
+    void FillN(double x, double y, size_type count)
+    {
+        auto& bin = this->Bin(x_.FindBin(x) + x_.size() * y_.FindBin(y));
+        bin.sum_w += count;
+        bin.sum_w2 += count;
+        num_entries_ += count;
+    }
+
+    //! Fold the bins filled in the current event
+    void EndEvent()
+    {
+        for (auto i : pending_)
+        {
+            this->Bin(i).EndEvent();
+        }
+        pending_.clear();
+    }
+
+    // Add the contents of a histogram with identical binning
+    inline void Merge(Histogram2D const& other);
+
+    //! Accumulate saved bin contents, e.g. from a checkpoint
+    void AddBin(size_type index, HistogramBin const& bin)
+    {
+        this->Bin(index) += bin;
+    }
+
+    //! Accumulate a saved number of fills
+    void AddEntries(size_type count) { num_entries_ += count; }
+
+    // Call a function with the global index and contents of occupied bins
+    template<class F>
+    inline void ForEachBin(F&& func) const;
+
+    //! X axis binning
+    HistogramAxis const& x_axis() const { return x_; }
+
+    //! Y axis binning
+    HistogramAxis const& y_axis() const { return y_; }
+
+    //! Number of cells including underflow and overflow
+    size_type num_cells() const { return x_.size() * y_.size(); }
+
+    //! Whether bins are stored in a hash map
+    bool is_sparse() const { return dense_.empty(); }
+
+    //! Number of fills
+    size_type num_entries() const { return num_entries_; }
+
+  private:
+    HistogramAxis x_;
+    HistogramAxis y_;
+    MapBin sparse_;
+    VecBin dense_;
+    std::vector<size_type> pending_;
+    size_type num_entries_{0};
+
+    // Access (and create) a bin, switching to dense storage if needed
+    inline HistogramBin& Bin(size_type index);
+
+    // Convert sparse storage to a dense array
+    inline void Densify();
+};
+
+//---------------------------------------------------------------------------//
+// INLINE DEFINITIONS
+//---------------------------------------------------------------------------//
+/*!
+ * Construct with uniform binning.
+ */
+HistogramAxis::HistogramAxis(size_type num_bins, double min, double max)
+    : num_bins_(num_bins)
+    , min_(min)
+    , max_(max)
+    , inv_width_(num_bins / (max - min))
+{
+    CELER_VALIDATE(num_bins > 0, << "histogram must have at least one bin");
+    CELER_VALIDATE(min < max,
+                   << "histogram range [" << min << ", " << max
+                   << ") is invalid");
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Construct with variable binning from bin edges.
+ */
+HistogramAxis::HistogramAxis(VecDbl edges) : edges_(std::move(edges))
+{
+    CELER_VALIDATE(edges_.size() >= 2,
+                   << "histogram must have at least two bin edges");
+    auto not_increasing = [](double a, double b) { return a >= b; };
+    CELER_VALIDATE(
+        std::adjacent_find(edges_.begin(), edges_.end(), not_increasing)
+            == edges_.end(),
+        << "histogram bin edges must be strictly increasing");
+    num_bins_ = edges_.size() - 1;
+    min_ = edges_.front();
+    max_ = edges_.back();
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Find bin index, including underflow (0) and overflow (num_bins + 1).
+ *
+ * NaN values are assigned to the underflow bin.
+ */
+auto HistogramAxis::FindBin(double x) const -> size_type
+{
+    if (!(x >= min_))
+    {
+        return 0;
+    }
+    if (x >= max_)
+    {
+        return num_bins_ + 1;
+    }
+    if (this->is_uniform())
+    {
+        // Guard against round-off at the upper edge
+        return std::min(static_cast<size_type>((x - min_) * inv_width_) + 1,
+                        num_bins_);
+    }
+    return std::upper_bound(edges_.begin(), edges_.end(), x) - edges_.begin();
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Bin edges, generated if the axis is uniform.
+ */
+auto HistogramAxis::MakeEdges() const -> VecDbl
+{
+    if (!this->is_uniform())
+    {
+        return edges_;
+    }
+    VecDbl result(num_bins_ + 1);
+    double const width = (max_ - min_) / num_bins_;
+    for (size_type i = 0; i < num_bins_; ++i)
+    {
+        result[i] = min_ + i * width;
+    }
+    result.back() = max_;
+    return result;
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Whether two axes have the same binning.
+ */
+bool HistogramAxis::operator==(HistogramAxis const& other) const
+{
+    return num_bins_ == other.num_bins_ && min_ == other.min_
+           && max_ == other.max_ && edges_ == other.edges_;
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Add the contents of a histogram with identical binning.
+ */
+void Histogram1D::Merge(Histogram1D const& other)
+{
+    CELER_VALIDATE(x_ == other.x_,
+                   << "cannot merge histograms with different binning");
+    CELER_EXPECT(other.pending_.empty());
+    for (size_type i = 0; i < bins_.size(); ++i)
+    {
+        bins_[i] += other.bins_[i];
+    }
+    num_entries_ += other.num_entries_;
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Add the contents of a histogram with identical binning.
+ */
+void Histogram2D::Merge(Histogram2D const& other)
+{
+    CELER_VALIDATE(x_ == other.x_ && y_ == other.y_,
+                   << "cannot merge histograms with different binning");
+    CELER_EXPECT(other.pending_.empty());
+    if (!other.is_sparse() && this->is_sparse())
+    {
+        this->Densify();
+    }
+    other.ForEachBin([this](size_type i, HistogramBin const& bin) {
+        this->Bin(i) += bin;
+    });
+    num_entries_ += other.num_entries_;
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Call a function with the global index and contents of occupied bins.
+ *
+ * Dense histograms visit every bin, including empty ones.
+ */
+template<class F>
+void Histogram2D::ForEachBin(F&& func) const
+{
+    if (this->is_sparse())
+    {
+        for (auto const& [i, bin] : sparse_)
+        {
+            func(i, bin);
+        }
+        return;
+    }
+    for (size_type i = 0; i < dense_.size(); ++i)
+    {
+        func(i, dense_[i]);
+    }
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Access (and create) a bin, switching to dense storage if needed.
+ */
+HistogramBin& Histogram2D::Bin(size_type index)
+{
+    CELER_EXPECT(index < this->num_cells());
+    if (!this->is_sparse())
+    {
+        return dense_[index];
+    }
+    auto& bin = sparse_[index];
+    if (4 * sparse_.size() <= this->num_cells())
+    {
+        return bin;
+    }
+    this->Densify();
+    return dense_[index];
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Convert sparse storage to a dense array.
+ */
+void Histogram2D::Densify()
+{
+    CELER_EXPECT(this->is_sparse());
+    dense_.resize(this->num_cells());
+    for (auto const& [i, bin] : sparse_)
+    {
+        dense_[i] = bin;
+    }
+    sparse_ = {};
+}
@@ -0,0 +1,230 @@
+//------------------------------- -*- C++ -*- -------------------------------//
+// Copyright Celeritas contributors: see top-level COPYRIGHT file for details
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+//---------------------------------------------------------------------------//
+//! \file celer-geant/src/HistogramRegistry.cc
+//---------------------------------------------------------------------------//
+#include "HistogramRegistry.hh"
+
+#include <algorithm>
+
+#include "JsonReader.hh"
+
+namespace
+{
+//---------------------------------------------------------------------------//
+/*!
+ * Default observables of the original, hard-coded histograms.
+ */
+struct LegacyHistogram
+{
+    char const* name;
+    Observable x;
+    Observable y;
+    Observable weight;
+    bool normalize;
+};
+
+constexpr auto none = Observable::size_;
+
+LegacyHistogram const legacy_histograms[] = {
+    {"energy_dep_x", Observable::pre_x, none, Observable::edep, true},
+    {"energy_dep_y", Observable::pre_y, none, Observable::edep, true},
+    {"energy_dep_z", Observable::pre_z, none, Observable::edep, true},
+    {"total_energy_dep", Observable::event_edep, none, none, false},
+    {"step_len", Observable::step_len, none, none, false},
+    {"pos_xy", Observable::pre_x, Observable::pre_y, none, false},
+    {"time", Observable::pre_time, none, none, false},
+    {"costheta", Observable::costheta, none, none, false},
+};
+
+//---------------------------------------------------------------------------//
+/*!
+ * Find default observables of a histogram, if any.
+ */
+LegacyHistogram const* find_legacy(std::string const& name)
+{
+    for (auto const& h : legacy_histograms)
+    {
+        if (name == h.name)
+        {
+            return &h;
+        }
+    }
+    return nullptr;
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Populate axis from JSON.
+ */
+HistogramAxis make_axis(nlohmann::json const& j, char const* name)
+{
+    JsonReader::ValidateHistogram(j, name);
+    auto const& jh = j.at(name);
+    if (jh.contains("edges"))
+    {
+        return HistogramAxis(jh.at("edges").get<std::vector<double>>());
+    }
+    return HistogramAxis(jh.at("num_bins").get<size_t>(),
+                         jh.at("min").get<double>(),
+                         jh.at("max").get<double>());
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Load an observable from JSON, or use the default one.
+ */
+Observable load_observable(nlohmann::json const& j,
+                           std::string const& hist_name,
+                           Observable default_obs)
+{
+    if (j.contains("observable"))
+    {
+        return to_observable(j.at("observable").get<std::string>());
+    }
+    CELER_VALIDATE(default_obs != Observable::size_,
+                   << "histogram \"" << hist_name
+                   << "\" is missing \"observable\" in JSON input");
+    return default_obs;
+}
+//---------------------------------------------------------------------------//
+}  // namespace
+
+//---------------------------------------------------------------------------//
+/*!
+ * Construct from the \c "histograms" JSON block.
+ *
+ * An entry with a \c "y" axis is a 2D histogram, in which case the binning
+ * and observable of each axis are defined in the \c "x" and \c "y" objects.
+ */
+HistogramRegistry::HistogramRegistry(nlohmann::json const& input)
+{
+    CELER_VALIDATE(input.is_object(),
+                   << "\"histograms\" must be a JSON object");
+
+    for (auto const& item : input.items())
+    {
+        auto const& name = item.key();
+        auto const& j = item.value();
+        auto const* legacy = find_legacy(name);
+
+        Definition def;
+        def.name = name;
+        def.weight = legacy ? legacy->weight : Observable::size_;
+        def.normalize = legacy && legacy->normalize;
+        if (j.contains("weight"))
+        {
+            def.weight = to_observable(j.at("weight").get<std::string>());
+        }
+        if (j.contains("normalize"))
+        {
+            def.normalize = j.at("normalize").get<bool>();
+        }
+
+        if (j.contains("y"))
+        {
+            def.dim = 2;
+            def.x = load_observable(
+                j.at("x"), name, legacy ? legacy->x : Observable::size_);
+            def.y = load_observable(
+                j.at("y"), name, legacy ? legacy->y : Observable::size_);
+            this->Insert(std::move(def), make_axis(j, "x"), make_axis(j, "y"));
+        }
+        else
+        {
+            def.dim = 1;
+            def.x = load_observable(
+                j, name, legacy ? legacy->x : Observable::size_);
+            this->Insert(std::move(def), make_axis(input, name.c_str()), {});
+        }
+    }
+
+    // Step observables are computed once per step
+    for (size_type i = 0; i < num_observables(); ++i)
+    {
+        auto const obs = static_cast<Observable>(i);
+        if (needed_[i] && !is_event_observable(obs))
+        {
+            step_observables_.push_back(obs);
+        }
+    }
+    for (auto obs : {Observable::post_x,
+                     Observable::post_y,
+                     Observable::post_z,
+                     Observable::post_time,
+                     Observable::post_energy,
+                     Observable::costheta})
+    {
+        needs_post_step_ = needs_post_step_ || this->Needs(obs);
+    }
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Fill event histograms for events with no scored steps.
+ *
+ * Every event observable is zero for these events.
+ */
+void HistogramRegistry::FillEmptyEvents(size_type count,
+                                        SensDetHistograms* hists) const
+{
+    CELER_EXPECT(hists);
+    if (count == 0)
+    {
+        return;
+    }
+    for (auto const& op : event_fills_1d_)
+    {
+        hists->h1d[op.index].FillN(0, count);
+    }
+    for (auto const& op : event_fills_2d_)
+    {
+        hists->h2d[op.index].FillN(0, 0, count);
+    }
+}
+
+//---------------------------------------------------------------------------//
+// PRIVATE
+//---------------------------------------------------------------------------//
+/*!
+ * Add a histogram definition and its fill operation.
+ */
+void HistogramRegistry::Insert(Definition def,
+                               HistogramAxis x,
+                               HistogramAxis y)
+{
+    bool const is_event = is_event_observable(def.x);
+    CELER_VALIDATE(def.dim == 1 || is_event_observable(def.y) == is_event,
+                   << "histogram \"" << def.name
+                   << "\" mixes step and event observables");
+    CELER_VALIDATE(def.weight == Observable::size_
+                       || (!is_event && !is_event_observable(def.weight)),
+                   << "histogram \"" << def.name
+                   << "\" weight must be a step observable and can only "
+                      "weight step histograms");
+
+    FillOp op{0, def.x, def.y, def.weight};
+    if (def.dim == 1)
+    {
+        op.index = prototype_.h1d.size();
+        prototype_.h1d.emplace_back(std::move(x));
+        (is_event ? event_fills_1d_ : step_fills_1d_).push_back(op);
+    }
+    else
+    {
+        op.index = prototype_.h2d.size();
+        prototype_.h2d.emplace_back(std::move(x), std::move(y));
+        (is_event ? event_fills_2d_ : step_fills_2d_).push_back(op);
+    }
+    def.index = op.index;
+
+    for (auto obs : {def.x, def.y, def.weight})
+    {
+        if (obs != Observable::size_)
+        {
+            needed_.set(static_cast<size_type>(obs));
+        }
+    }
+    defs_.push_back(std::move(def));
+}
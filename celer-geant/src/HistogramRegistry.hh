@@ -0,0 +1,233 @@
+//------------------------------- -*- C++ -*- -------------------------------//
+// Copyright Celeritas contributors: see top-level COPYRIGHT file for details
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+//---------------------------------------------------------------------------//
+//! \file celer-geant/src/HistogramRegistry.hh
+//---------------------------------------------------------------------------//
+#pragma once
+
+#include <bitset>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <corecel/Assert.hh>
+#include <nlohmann/json.hpp>
+
+#include "Histogram.hh"
+#include "Observable.hh"
+
+//---------------------------------------------------------------------------//
+/*!
+ * Histograms scored for a single sensitive detector.
+ *
+ * Histograms are stored as lightweight \c Histogram1D / \c Histogram2D ,
+ * indexed by \c HistogramRegistry::Definition::index , and only converted to
+ * ROOT objects by \c write_histograms .
+ */
+struct SensDetHistograms
+{
+    std::vector<Histogram1D> h1d;
+    std::vector<Histogram2D> h2d;
+
+    //! Accumulate histograms of the same SD from another thread
+    void Merge(SensDetHistograms const& other)
+    {
+        CELER_EXPECT(h1d.size() == other.h1d.size()
+                     && h2d.size() == other.h2d.size());
+        for (size_t i = 0; i < h1d.size(); ++i)
+        {
+            h1d[i].Merge(other.h1d[i]);
+        }
+        for (size_t i = 0; i < h2d.size(); ++i)
+        {
+            h2d[i].Merge(other.h2d[i]);
+        }
+    }
+
+    //! Fold the bins filled in the current event
+    void EndEvent()
+    {
+        for (auto& h : h1d)
+        {
+            h.EndEvent();
+        }
+        for (auto& h : h2d)
+        {
+            h.EndEvent();
+        }
+    }
+};
+
+//---------------------------------------------------------------------------//
+/*!
+ * Histograms declared in the JSON input, compiled into a flat fill plan.
+ *
+ * Every entry of the \c "histograms" JSON block defines a histogram of one
+ * or two observables from the \c Observable catalog, with an optional weight
+ * observable and normalization by the number of events:
+ * \code
+   "histograms": {
+       "edep_z": {"observable": "pre_z", "weight": "edep", "normalize": true,
+                  "num_bins": 100, "min": 0, "max": 100},
+       "pos_rz": {"x": {"observable": "pre_z", "edges": [0, 1, 10, 100]},
+                  "y": {"observable": "pre_r",
+                        "num_bins": 10, "min": 0, "max": 10}}
+   }
+   \endcode
+ *
+ * The original histogram names (\c energy_dep_x , \c total_energy_dep ,
+ * \c pos_xy , etc.) have default observables, so only their binning is
+ * required.
+ *
+ * At construction the registry builds a list of fill operations for step and
+ * event observables, and the set of step observables that at least one
+ * histogram needs, so that filling a step only computes those.
+ */
+class HistogramRegistry
+{
+  public:
+    //!@{
+    //! \name Type aliases
+    using size_type = size_t;
+    //!@}
+
+    //! Histogram declaration
+    struct Definition
+    {
+        std::string name;
+        size_type dim{1};  //!< Number of dimensions
+        size_type index{0};  //!< Index into SensDetHistograms h1d or h2d
+        Observable x{Observable::size_};
+        Observable y{Observable::size_};  //!< Unused for 1D
+        Observable weight{Observable::size_};  //!< Unit weight if unset
+        bool normalize{false};  //!< Divide by the number of events
+    };
+
+    using VecDefinition = std::vector<Definition>;
+
+  public:
+    // Construct from the "histograms" JSON block
+    explicit HistogramRegistry(nlohmann::json const& input);
+
+    // Fill step histograms
+    inline void
+    FillStep(StepRecord const& step, SensDetHistograms* hists) const;
+
+    // Fill event histograms with accumulated event observables
+    inline void
+    FillEvent(ObservableValues const& values, SensDetHistograms* hists) const;
+
+    // Fill event histograms for events with no scored steps
+    void FillEmptyEvents(size_type count, SensDetHistograms* hists) const;
+
+    //! Empty histograms for a sensitive detector
+    SensDetHistograms const& Prototype() const { return prototype_; }
+
+    //! Histogram declarations
+    VecDefinition const& Definitions() const { return defs_; }
+
+    //! Whether any histogram needs an observable
+    bool Needs(Observable obs) const
+    {
+        return needed_[static_cast<size_type>(obs)];
+    }
+
+    //! Whether any histogram needs post-step point data
+    bool NeedsPostStep() const { return needs_post_step_; }
+
+  private:
+    //// TYPES ////
+
+    struct FillOp
+    {
+        size_type index;
+        Observable x;
+        Observable y;
+        Observable weight;
+    };
+
+    //// DATA ////
+
+    VecDefinition defs_;
+    SensDetHistograms prototype_;
+    std::vector<Observable> step_observables_;
+    std::vector<FillOp> step_fills_1d_;
+    std::vector<FillOp> step_fills_2d_;
+    std::vector<FillOp> event_fills_1d_;
+    std::vector<FillOp> event_fills_2d_;
+    std::bitset<num_observables()> needed_;
+    bool needs_post_step_{false};
+
+    //// HELPER FUNCTIONS ////
+
+    void Insert(Definition def, HistogramAxis x, HistogramAxis y);
+
+    static inline void Fill(std::vector<FillOp> const& fills_1d,
+                            std::vector<FillOp> const& fills_2d,
+                            ObservableValues const& values,
+                            SensDetHistograms* hists);
+};
+
+//---------------------------------------------------------------------------//
+// INLINE DEFINITIONS
+//---------------------------------------------------------------------------//
+/*!
+ * Fill step histograms.
+ */
+void HistogramRegistry::FillStep(StepRecord const& step,
+                                 SensDetHistograms* hists) const
+{
+    CELER_EXPECT(hists);
+    ObservableValues values;
+    for (auto obs : step_observables_)
+    {
+        values[static_cast<size_type>(obs)] = calc_observable(obs, step);
+    }
+    HistogramRegistry::Fill(step_fills_1d_, step_fills_2d_, values, hists);
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Fill event histograms with accumulated event observables.
+ */
+void HistogramRegistry::FillEvent(ObservableValues const& values,
+                                  SensDetHistograms* hists) const
+{
+    CELER_EXPECT(hists);
+    HistogramRegistry::Fill(event_fills_1d_, event_fills_2d_, values, hists);
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Execute a list of fill operations.
+ *
+ * Entries whose observables are undefined (NaN) are skipped.
+ */
+void HistogramRegistry::Fill(std::vector<FillOp> const& fills_1d,
+                             std::vector<FillOp> const& fills_2d,
+                             ObservableValues const& values,
+                             SensDetHistograms* hists)
+{
+    auto get = [&values](Observable obs) {
+        return obs == Observable::size_ ? 1.
+                                        : values[static_cast<size_type>(obs)];
+    };
+
+    for (auto const& op : fills_1d)
+    {
+        auto const x = get(op.x);
+        if (!std::isnan(x))
+        {
+            hists->h1d[op.index].Fill(x, get(op.weight));
+        }
+    }
+    for (auto const& op : fills_2d)
+    {
+        auto const x = get(op.x);
+        auto const y = get(op.y);
+        if (!std::isnan(x) && !std::isnan(y))
+        {
+            hists->h2d[op.index].Fill(x, y, get(op.weight));
+        }
+    }
+}
@@ -0,0 +1,182 @@
+//------------------------------- -*- C++ -*- -------------------------------//
+// Copyright Celeritas contributors: see top-level COPYRIGHT file for details
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+//---------------------------------------------------------------------------//
+//! \file celer-geant/src/HistogramWriter.cc
+//---------------------------------------------------------------------------//
+#include "HistogramWriter.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <TFile.h>
+#include <TH1D.h>
+#include <TH2D.h>
+#include <corecel/Assert.hh>
+
+//---------------------------------------------------------------------------//
+/*!
+ * Statistical error of a bin content summed over events.
+ *
+ * The bin holds the sum and sum of squares of its per-event contents, so the
+ * error is estimated from the sample variance of the events:
+ * \f[
+   \sigma = \sqrt{\frac{N}{N-1} \left(\sum s_e^2 - (\sum s_e)^2/N\right)}
+ * \f]
+ * which becomes the standard error of the mean once the histogram is divided
+ * by the number of events.
+ */
+double event_error(HistogramBin const& bin, size_t num_events)
+{
+    if (num_events < 2)
+    {
+        return std::sqrt(bin.sum_w2);
+    }
+    double const n = num_events;
+    double const var = bin.sum_w2 - bin.sum_w * bin.sum_w / n;
+    // Round-off may produce a slightly negative variance
+    return std::sqrt(std::max(var, 0.0) * n / (n - 1));
+}
+
+namespace
+{
+//---------------------------------------------------------------------------//
+/*!
+ * Copy bin contents, errors, and statistics to a ROOT histogram.
+ *
+ * Only occupied bins of sparse histograms are visited; the remaining bins of
+ * the newly constructed ROOT histogram are already zero.
+ */
+template<class H, class T>
+void copy_bins(H const& hist, size_t num_events, T* result)
+{
+    auto const num_cells = static_cast<size_t>(result->GetNcells());
+    hist.ForEachBin([&](size_t i, HistogramBin const& bin) {
+        CELER_ASSERT(i < num_cells);
+        result->SetBinContent(i, bin.sum_w);
+        result->SetBinError(i, event_error(bin, num_events));
+    });
+    result->ResetStats();
+    result->SetEntries(hist.num_entries());
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Convert a \c Histogram1D to a ROOT \c TH1D .
+ */
+TH1D to_root(Histogram1D const& hist,
+             size_t num_events,
+             std::string name,
+             std::string title)
+{
+    auto const& x = hist.axis();
+    TH1D result = x.is_uniform() ? TH1D(name.c_str(),
+                                        title.c_str(),
+                                        x.num_bins(),
+                                        x.min(),
+                                        x.max())
+                                 : TH1D(name.c_str(),
+                                        title.c_str(),
+                                        x.num_bins(),
+                                        x.edges().data());
+    result.SetDirectory(nullptr);
+    copy_bins(hist, num_events, &result);
+    return result;
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Convert a \c Histogram2D to a ROOT \c TH2D .
+ */
+TH2D to_root(Histogram2D const& hist,
+             size_t num_events,
+             std::string name,
+             std::string title)
+{
+    auto const& x = hist.x_axis();
+    auto const& y = hist.y_axis();
+    TH2D result;
+    if (x.is_uniform() && y.is_uniform())
+    {
+        result = TH2D(name.c_str(),
+                      title.c_str(),
+                      x.num_bins(),
+                      x.min(),
+                      x.max(),
+                      y.num_bins(),
+                      y.min(),
+                      y.max());
+    }
+    else
+    {
+        auto const x_edges = x.MakeEdges();
+        auto const y_edges = y.MakeEdges();
+        result = TH2D(name.c_str(),
+                      title.c_str(),
+                      x.num_bins(),
+                      x_edges.data(),
+                      y.num_bins(),
+                      y_edges.data());
+    }
+    result.SetDirectory(nullptr);
+    copy_bins(hist, num_events, &result);
+    return result;
+}
+//---------------------------------------------------------------------------//
+}  // namespace
+
+//---------------------------------------------------------------------------//
+/*!
+ * Write the histograms of every hit SD to \c histograms/[sd] directories.
+ *
+ * The event count is used for the per-event errors and for normalized
+ * histograms. SDs that were never hit have no histograms and are skipped;
+ * their number is returned.
+ */
+size_t write_histograms(TFile& file,
+                        RootDataStore::VecSensDetData const& sensdets,
+                        HistogramRegistry const& registry,
+                        size_t num_events)
+{
+    std::string const hist_folder = "histograms/";
+
+    size_t num_skipped = 0;
+    for (auto const& data : sensdets)
+    {
+        if (!data.hists)
+        {
+            // Never hit: histograms were not allocated
+            ++num_skipped;
+            continue;
+        }
+        auto const& hists = *data.hists;
+
+        std::string dir_name = hist_folder + data.sd_name;
+        auto hist_sd_dir = file.mkdir(dir_name.c_str());
+        hist_sd_dir->cd();
+
+        for (auto const& def : registry.Definitions())
+        {
+            auto write = [&](auto const& hist) {
+                auto h = to_root(hist,
+                                 num_events,
+                                 def.name,
+                                 data.sd_name + "_" + def.name);
+                if (def.normalize)
+                {
+                    h.Scale(1. / num_events);
+                }
+                h.Write();
+            };
+            if (def.dim == 1)
+            {
+                write(hists.h1d[def.index]);
+            }
+            else
+            {
+                write(hists.h2d[def.index]);
+            }
+        }
+    }
+    return num_skipped;
+}
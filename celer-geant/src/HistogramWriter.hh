@@ -0,0 +1,24 @@
+//------------------------------- -*- C++ -*- -------------------------------//
+// Copyright Celeritas contributors: see top-level COPYRIGHT file for details
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+//---------------------------------------------------------------------------//
+//! \file celer-geant/src/HistogramWriter.hh
+//---------------------------------------------------------------------------//
+#pragma once
+
+#include <cstddef>
+
+#include "RootDataStore.hh"
+
+class TFile;
+
+//---------------------------------------------------------------------------//
+// Statistical error of a bin content summed over events
+double event_error(HistogramBin const& bin, size_t num_events);
+
+//---------------------------------------------------------------------------//
+// Write the histograms of every hit SD to "histograms/[sd]" directories
+size_t write_histograms(TFile& file,
+                        RootDataStore::VecSensDetData const& sensdets,
+                        HistogramRegistry const& registry,
+                        size_t num_events);
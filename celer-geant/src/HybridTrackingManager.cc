@@ -0,0 +1,242 @@
+//------------------------------- -*- C++ -*- -------------------------------//
+// Copyright Celeritas contributors: see top-level COPYRIGHT file for details
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+//---------------------------------------------------------------------------//
+//! \file celer-geant/src/HybridTrackingManager.cc
+//---------------------------------------------------------------------------//
+#include "HybridTrackingManager.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <unordered_map>
+#include <G4AutoDelete.hh>
+#include <G4EventManager.hh>
+#include <G4LogicalVolume.hh>
+#include <G4Navigator.hh>
+#include <G4ParticleTable.hh>
+#include <G4RegionStore.hh>
+#include <G4SystemOfUnits.hh>
+#include <G4Track.hh>
+#include <G4TrackingManager.hh>
+#include <G4TransportationManager.hh>
+#include <G4VPhysicalVolume.hh>
+#include <corecel/Assert.hh>
+#include <corecel/io/Logger.hh>
+
+#include "Profiler.hh"
+
+namespace
+{
+//---------------------------------------------------------------------------//
+//! Counters of all threads, accumulated at every flush.
+std::atomic<size_t> total_offloaded{0};
+std::atomic<size_t> total_below_energy{0};
+std::atomic<size_t> total_outside_region{0};
+
+//---------------------------------------------------------------------------//
+}  // namespace
+
+//---------------------------------------------------------------------------//
+/*!
+ * Wrap the Celeritas tracking manager of every offloaded particle.
+ *
+ * This is called on every thread while constructing processes. Particles
+ * that share a Celeritas tracking manager share the hybrid one, so that an
+ * event is flushed once.
+ */
+void HybridTrackingManager::WrapOffloaded()
+{
+    auto const& config = Config::Instance();
+    CELER_EXPECT(config.offload_policy.enabled());
+
+    std::unordered_map<G4VTrackingManager*, HybridTrackingManager*> wrapped;
+    auto* particles = G4ParticleTable::GetParticleTable();
+    for (auto pdg : config.offload_pdgs.pdgs())
+    {
+        auto* particle = particles->FindParticle(pdg);
+        if (!particle || !particle->GetTrackingManager())
+        {
+            continue;
+        }
+        auto*& hybrid = wrapped[particle->GetTrackingManager()];
+        if (!hybrid)
+        {
+            hybrid = new HybridTrackingManager(particle->GetTrackingManager(),
+                                               config.offload_policy);
+            G4AutoDelete::Register(hybrid);
+        }
+        particle->SetTrackingManager(hybrid);
+    }
+    CELER_VALIDATE(!wrapped.empty(),
+                   << "offload policy is set but no offloaded particle has "
+                      "a Celeritas tracking manager");
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Counters of all threads, up to the last flushed event.
+ */
+auto HybridTrackingManager::Totals() -> Counters
+{
+    Counters result;
+    result.offloaded = total_offloaded.load();
+    result.below_energy = total_below_energy.load();
+    result.outside_region = total_outside_region.load();
+    return result;
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Construct with the wrapped Celeritas tracking manager.
+ */
+HybridTrackingManager::HybridTrackingManager(G4VTrackingManager* offload,
+                                             OffloadPolicy const& policy)
+    : offload_(offload), min_energy_(policy.min_energy * MeV)
+{
+    CELER_EXPECT(offload_);
+    auto* store = G4RegionStore::GetInstance();
+    for (auto const& name : policy.regions)
+    {
+        auto const* region = store->GetRegion(name, /* verbose = */ false);
+        CELER_VALIDATE(region,
+                       << "offload policy region '" << name
+                       << "' does not exist");
+        regions_.push_back(region);
+    }
+}
+
+//---------------------------------------------------------------------------//
+//! Default destructor.
+HybridTrackingManager::~HybridTrackingManager() = default;
+
+//---------------------------------------------------------------------------//
+/*!
+ * Build the Geant4 physics tables through Celeritas.
+ *
+ * Celeritas builds the process tables that both the offloaded and the Geant4
+ * tracks use.
+ */
+void HybridTrackingManager::BuildPhysicsTable(G4ParticleDefinition const& part)
+{
+    offload_->BuildPhysicsTable(part);
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Prepare the Geant4 physics tables through Celeritas.
+ */
+void HybridTrackingManager::PreparePhysicsTable(
+    G4ParticleDefinition const& part)
+{
+    offload_->PreparePhysicsTable(part);
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Offload the track or transport it in Geant4.
+ */
+void HybridTrackingManager::HandOverOneTrack(G4Track* track)
+{
+    CELER_EXPECT(track);
+    if (track->GetKineticEnergy() < min_energy_)
+    {
+        ++counters_.below_energy;
+        this->TrackInGeant4(track);
+    }
+    else if (!regions_.empty() && !this->InRegion(*track))
+    {
+        ++counters_.outside_region;
+        this->TrackInGeant4(track);
+    }
+    else
+    {
+        ++counters_.offloaded;
+        if constexpr (Profiler::enabled())
+        {
+            Profiler::Instance().CountTrack(true);
+        }
+        offload_->HandOverOneTrack(track);
+    }
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Flush the Celeritas buffer and accumulate the counters.
+ */
+void HybridTrackingManager::FlushEvent()
+{
+    offload_->FlushEvent();
+
+    total_offloaded += counters_.offloaded;
+    total_below_energy += counters_.below_energy;
+    total_outside_region += counters_.outside_region;
+    counters_ = {};
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Whether a track starts in one of the policy regions.
+ *
+ * Primaries are handed over before Geant4 locates them, so their volume is
+ * found with a navigator of this thread.
+ */
+bool HybridTrackingManager::InRegion(G4Track const& track)
+{
+    G4VPhysicalVolume const* pv = track.GetVolume();
+    if (!pv)
+    {
+        if (!navigator_)
+        {
+            navigator_ = std::make_unique<G4Navigator>();
+            navigator_->SetWorldVolume(
+                G4TransportationManager::GetTransportationManager()
+                    ->GetNavigatorForTracking()
+                    ->GetWorldVolume());
+        }
+        pv = navigator_->LocateGlobalPointAndSetup(
+            track.GetPosition(), nullptr, false, /* ignore_dir = */ true);
+    }
+    if (!pv)
+    {
+        // Outside the world
+        return false;
+    }
+
+    auto const* region = pv->GetLogicalVolume()->GetRegion();
+    return std::find(regions_.begin(), regions_.end(), region)
+           != regions_.end();
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Transport a track and stack its secondaries.
+ *
+ * This follows what \c G4EventManager does for particles without a tracking
+ * manager of their own; the track is owned by this tracking manager once it
+ * is handed over. EM processes never suspend or postpone a track.
+ */
+void HybridTrackingManager::TrackInGeant4(G4Track* track)
+{
+    if constexpr (Profiler::enabled())
+    {
+        Profiler::Instance().CountKeptTrack();
+    }
+
+    auto* event_manager = G4EventManager::GetEventManager();
+    auto* tracking = event_manager->GetTrackingManager();
+    tracking->ProcessOneTrack(track);
+
+    auto* secondaries = tracking->GimmeSecondaries();
+    auto const status = track->GetTrackStatus();
+    CELER_ASSERT(status == fStopAndKill || status == fKillTrackAndSecondaries);
+    if (status == fKillTrackAndSecondaries)
+    {
+        for (auto* secondary : *secondaries)
+        {
+            delete secondary;
+        }
+        secondaries->clear();
+    }
+    event_manager->StackTracks(secondaries);
+    delete track;
+}
@@ -0,0 +1,120 @@
+//------------------------------- -*- C++ -*- -------------------------------//
+// Copyright Celeritas contributors: see top-level COPYRIGHT file for details
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+//---------------------------------------------------------------------------//
+//! \file celer-geant/src/HybridTrackingManager.hh
+//---------------------------------------------------------------------------//
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <G4VPhysicsConstructor.hh>
+#include <G4VTrackingManager.hh>
+
+#include "Config.hh"
+
+class G4Navigator;
+class G4Region;
+
+//---------------------------------------------------------------------------//
+/*!
+ * Offload a track to Celeritas only if it passes the \c OffloadPolicy .
+ *
+ * The policy is set by the optional \c "offload_policy" of the
+ * \c "celeritas" JSON block:
+ * \code
+   "celeritas": {
+       "offload_policy": {"min_energy": 100, "regions": ["Calorimeter"]}
+   }
+   \endcode
+ *
+ * A track is offloaded if its kinetic energy is at least \c min_energy [MeV]
+ * and it starts in one of the listed regions (any region if \c "regions" is
+ * absent). Other tracks, typically the low-energy tail that arrives one at a
+ * time and would still pay the Celeritas buffering and flush cost, are
+ * transported on the spot by the Geant4 tracking manager of the event. Both
+ * paths use the same physics list and score through the same sensitive
+ * detectors, so scoring results are statistically equivalent, although not
+ * reproduced bit for bit since the two transport codes sample and step
+ * differently.
+ *
+ * The decision is made once, when the track is handed over: a Geant4 track
+ * that later enters a region or is above the threshold stays in Geant4, and
+ * its secondaries are again subject to the policy.
+ *
+ * One instance wraps the Celeritas tracking manager of every offloaded
+ * particle type on each thread (see \c HybridOffloadConstructor ).
+ */
+class HybridTrackingManager final : public G4VTrackingManager
+{
+  public:
+    //! Number of tracks handed over, by decision
+    struct Counters
+    {
+        size_t offloaded{0};
+        size_t below_energy{0};  //!< Kept in Geant4
+        size_t outside_region{0};  //!< Kept in Geant4
+    };
+
+  public:
+    // Wrap the Celeritas tracking manager of every offloaded particle
+    static void WrapOffloaded();
+
+    // Counters of all threads, up to the last flushed event
+    static Counters Totals();
+
+    // Construct with the wrapped Celeritas tracking manager
+    HybridTrackingManager(G4VTrackingManager* offload,
+                          OffloadPolicy const& policy);
+
+    // Default destructor
+    ~HybridTrackingManager() final;
+
+    // Build the Geant4 physics tables through Celeritas
+    void BuildPhysicsTable(G4ParticleDefinition const& part) final;
+
+    // Prepare the Geant4 physics tables through Celeritas
+    void PreparePhysicsTable(G4ParticleDefinition const& part) final;
+
+    // Offload the track or transport it in Geant4
+    void HandOverOneTrack(G4Track* track) final;
+
+    // Flush the Celeritas buffer and accumulate the counters
+    void FlushEvent() final;
+
+  private:
+    G4VTrackingManager* offload_;  //!< Owned by the particle definition
+    double min_energy_;
+    std::vector<G4Region const*> regions_;
+    std::unique_ptr<G4Navigator> navigator_;
+    Counters counters_;
+
+    // Whether a track starts in one of the policy regions
+    bool InRegion(G4Track const& track);
+
+    // Transport a track and stack its secondaries
+    void TrackInGeant4(G4Track* track);
+};
+
+//---------------------------------------------------------------------------//
+/*!
+ * Install the hybrid offload policy after the Celeritas tracking managers.
+ *
+ * This must be registered after \c celeritas::TrackingManagerConstructor ,
+ * whose tracking managers are wrapped in \c ConstructProcess .
+ */
+class HybridOffloadConstructor final : public G4VPhysicsConstructor
+{
+  public:
+    //! Construct with a fixed name
+    HybridOffloadConstructor()
+        : G4VPhysicsConstructor("hybrid-offload")
+    {
+    }
+
+    //! No particles are added
+    void ConstructParticle() final {}
+
+    //! Wrap the Celeritas tracking managers
+    void ConstructProcess() final { HybridTrackingManager::WrapOffloaded(); }
+};
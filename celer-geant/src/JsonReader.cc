@@ -50,12 +50,22 @@ void JsonReader::Validate(nlohmann::json const& j, std::string name)
 //---------------------------------------------------------------------------//
 /*!
  * Throw run-time error if JSON histogram keys are not present.
+ *
+ * Histograms are defined either with uniform binning (\c num_bins , \c min ,
+ * and \c max ) or with variable binning (\c edges ).
  */
 void JsonReader::ValidateHistogram(nlohmann::json const& j,
                                    std::string hist_name)
 {
     JsonReader::Validate(j, hist_name);
     auto const& jh = j.at(hist_name);
+    if (jh.contains("edges"))
+    {
+        CELER_VALIDATE(jh.at("edges").is_array(),
+                       << "Histogram \"" << hist_name
+                       << "\" bin edges must be an array in JSON input.");
+        return;
+    }
 
 #define JR_HIST_VALIDATE(MEMBER)                                        \
     CELER_VALIDATE(jh.contains(#MEMBER),                                \
@@ -16,8 +16,13 @@
 #include <accel/SetupOptions.hh>
 #include <accel/TrackingManagerConstructor.hh>
 #include <celeritas/phys/PDGNumber.hh>
+#include <celeritas/user/StepCollector.hh>
 #include <corecel/Assert.hh>
 
+#include "BatchedStepScorer.hh"
+#include "Calibration.hh"
+#include "Config.hh"
+#include "FieldSetup.hh"
 #include "JsonReader.hh"
 
 //---------------------------------------------------------------------------/
@@ -81,10 +86,40 @@ celeritas::SetupOptions MakeCelerOptions()
                "Using default list.";
     }
 
-    opts.sd.ignore_zero_deposition = false;
+    bool const batched = BatchedStepScorer::Enabled();
+    bool const warmup = Calibration::IsWarmup();
+    if (batched)
+    {
+        // Score step batches directly instead of reconstructing G4Steps
+        opts.sd.enabled = false;
+    }
+    else
+    {
+        opts.sd.ignore_zero_deposition = false;
+    }
+    bool const meshes = Config::Instance().HasMeshes();
+    if (batched || warmup || meshes)
+    {
+        opts.add_user_actions = [batched, warmup, meshes](
+                                    celeritas::CoreParams const& params) {
+            CELER_VALIDATE(batched || !meshes,
+                           << "scoring meshes need \"step_scoring\": "
+                              "\"batched\" to score Celeritas steps");
+            if (batched)
+            {
+                celeritas::StepCollector::make_and_insert(
+                    params, {std::make_shared<BatchedStepScorer>(params)});
+            }
+            if (warmup)
+            {
+                // Measure track slot usage of a calibration run
+                Calibration::InsertMonitor(params);
+            }
+        };
+    }
 
-    // Set along-step factory with zero field
-    opts.make_along_step = celeritas::UniformAlongStepFactory();
+    // Set along-step factory with the optional field
+    opts.make_along_step = FieldSetup::MakeAlongStep();
 
     return opts;
 }
@@ -0,0 +1,187 @@
+//------------------------------- -*- C++ -*- -------------------------------//
+// Copyright Celeritas contributors: see top-level COPYRIGHT file for details
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+//---------------------------------------------------------------------------//
+//! \file celer-geant/src/Observable.hh
+//---------------------------------------------------------------------------//
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <corecel/Assert.hh>
+
+//---------------------------------------------------------------------------//
+/*!
+ * Catalog of quantities that can be histogrammed.
+ *
+ * Step observables are computed from a single \c StepRecord , while event
+ * observables are accumulated over all steps of an event in a sensitive
+ * detector. Units are [cm], [MeV], and [ns].
+ */
+enum class Observable
+{
+    // Step observables
+    pre_x,  //!< Pre-step x position
+    pre_y,  //!< Pre-step y position
+    pre_z,  //!< Pre-step z position
+    post_x,  //!< Post-step x position
+    post_y,  //!< Post-step y position
+    post_z,  //!< Post-step z position
+    pre_r,  //!< Pre-step transverse radius
+    edep,  //!< Step energy deposition
+    step_len,  //!< Step length
+    pre_time,  //!< Pre-step global time
+    post_time,  //!< Post-step global time
+    pre_energy,  //!< Pre-step kinetic energy
+    post_energy,  //!< Post-step kinetic energy
+    costheta,  //!< Pre/post step direction dot product
+    // Event observables
+    event_edep,  //!< Total energy deposition in the event
+    event_num_steps,  //!< Number of scored steps in the event
+    size_
+};
+
+//---------------------------------------------------------------------------//
+//! Number of observables in the catalog
+inline constexpr size_t num_observables()
+{
+    return static_cast<size_t>(Observable::size_);
+}
+
+//---------------------------------------------------------------------------//
+//! Values of every observable, of which only the needed ones are computed
+using ObservableValues = std::array<double, num_observables()>;
+
+//---------------------------------------------------------------------------//
+/*!
+ * Minimal, framework-independent description of a scored step.
+ *
+ * This is filled from a \c G4Step by the sensitive detector, but has no
+ * Geant4 dependency so that it can also be filled from other sources.
+ */
+struct StepRecord
+{
+    using Real3 = std::array<double, 3>;
+
+    struct Point
+    {
+        Real3 pos{};  //!< Position [cm]
+        Real3 dir{};  //!< Momentum direction
+        double energy{};  //!< Kinetic energy [MeV]
+        double time{};  //!< Global time [ns]
+    };
+
+    Point pre;
+    Point post;
+    double edep{};  //!< Energy deposition [MeV]
+    double step_len{};  //!< Step length [cm]
+    bool has_dir{false};  //!< Whether the direction change is defined
+};
+
+//---------------------------------------------------------------------------//
+// FREE FUNCTIONS
+//---------------------------------------------------------------------------//
+//! Whether the observable is accumulated over an event
+inline constexpr bool is_event_observable(Observable obs)
+{
+    return obs >= Observable::event_edep;
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Get the catalog name of an observable.
+ */
+inline char const* to_cstring(Observable obs)
+{
+    static char const* const names[] = {
+        "pre_x",
+        "pre_y",
+        "pre_z",
+        "post_x",
+        "post_y",
+        "post_z",
+        "pre_r",
+        "edep",
+        "step_len",
+        "pre_time",
+        "post_time",
+        "pre_energy",
+        "post_energy",
+        "costheta",
+        "event_edep",
+        "event_num_steps",
+    };
+    static_assert(sizeof(names) / sizeof(names[0]) == num_observables());
+    CELER_EXPECT(obs < Observable::size_);
+    return names[static_cast<size_t>(obs)];
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Find an observable from its catalog name.
+ */
+inline Observable to_observable(std::string const& name)
+{
+    for (size_t i = 0; i < num_observables(); ++i)
+    {
+        auto const obs = static_cast<Observable>(i);
+        if (name == to_cstring(obs))
+        {
+            return obs;
+        }
+    }
+    CELER_VALIDATE(false, << "unknown histogram observable '" << name << "'");
+    return Observable::size_;
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Compute a step observable.
+ *
+ * Undefined values (e.g. the direction change of a track's first step) are
+ * returned as NaN, and are not histogrammed.
+ */
+inline double calc_observable(Observable obs, StepRecord const& step)
+{
+    switch (obs)
+    {
+        case Observable::pre_x:
+            return step.pre.pos[0];
+        case Observable::pre_y:
+            return step.pre.pos[1];
+        case Observable::pre_z:
+            return step.pre.pos[2];
+        case Observable::post_x:
+            return step.post.pos[0];
+        case Observable::post_y:
+            return step.post.pos[1];
+        case Observable::post_z:
+            return step.post.pos[2];
+        case Observable::pre_r:
+            return std::hypot(step.pre.pos[0], step.pre.pos[1]);
+        case Observable::edep:
+            return step.edep;
+        case Observable::step_len:
+            return step.step_len;
+        case Observable::pre_time:
+            return step.pre.time;
+        case Observable::post_time:
+            return step.post.time;
+        case Observable::pre_energy:
+            return step.pre.energy;
+        case Observable::post_energy:
+            return step.post.energy;
+        case Observable::costheta:
+            if (!step.has_dir)
+            {
+                return std::numeric_limits<double>::quiet_NaN();
+            }
+            return step.pre.dir[0] * step.post.dir[0]
+                   + step.pre.dir[1] * step.post.dir[1]
+                   + step.pre.dir[2] * step.post.dir[2];
+        default:
+            CELER_ASSERT_UNREACHABLE();
+    }
+}
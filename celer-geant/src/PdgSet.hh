@@ -0,0 +1,108 @@
+//------------------------------- -*- C++ -*- -------------------------------//
+// Copyright Celeritas contributors: see top-level COPYRIGHT file for details
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+//---------------------------------------------------------------------------//
+//! \file celer-geant/src/PdgSet.hh
+//---------------------------------------------------------------------------//
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+//---------------------------------------------------------------------------//
+/*!
+ * Compiled set of PDG codes with a branch-light membership test.
+ *
+ * When the codes span a small range (e.g. leptons, photons, and light
+ * hadrons), membership is a single bit test in a bitset offset by the
+ * smallest code. Sets spanning a large range (e.g. ions, with 10-digit PDG
+ * codes) fall back to a binary search over the sorted codes.
+ * \code
+   PdgSet pdgs({11, -11, 22});
+   if (pdgs.contains(pd->GetPDGEncoding())) { ... }
+   \endcode
+ */
+class PdgSet
+{
+  public:
+    //!@{
+    //! \name Type aliases
+    using PDG = int;
+    using VecPDG = std::vector<PDG>;
+    //!@}
+
+    //! Largest code range stored as a bitset
+    static constexpr std::int64_t max_bitset_range() { return 1 << 16; }
+
+  public:
+    //! Construct empty
+    PdgSet() = default;
+
+    // Construct from a list of PDG codes
+    inline explicit PdgSet(VecPDG pdgs);
+
+    // Whether the PDG code is in the set
+    inline bool contains(PDG pdg) const;
+
+    //! Whether the set is empty
+    bool empty() const { return sorted_.empty(); }
+
+    //! Sorted unique PDG codes
+    VecPDG const& pdgs() const { return sorted_; }
+
+  private:
+    VecPDG sorted_;
+    std::vector<std::uint64_t> bits_;
+    PDG min_{0};
+};
+
+//---------------------------------------------------------------------------//
+// INLINE DEFINITIONS
+//---------------------------------------------------------------------------//
+/*!
+ * Construct from a list of PDG codes.
+ */
+PdgSet::PdgSet(VecPDG pdgs) : sorted_(std::move(pdgs))
+{
+    std::sort(sorted_.begin(), sorted_.end());
+    sorted_.erase(std::unique(sorted_.begin(), sorted_.end()), sorted_.end());
+    if (sorted_.empty())
+    {
+        return;
+    }
+
+    min_ = sorted_.front();
+    auto const range = static_cast<std::int64_t>(sorted_.back())
+                       - static_cast<std::int64_t>(min_) + 1;
+    if (range > max_bitset_range())
+    {
+        return;
+    }
+
+    bits_.resize((range + 63) / 64);
+    for (auto pdg : sorted_)
+    {
+        auto const i = static_cast<std::uint64_t>(pdg - min_);
+        bits_[i / 64] |= std::uint64_t{1} << (i % 64);
+    }
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Whether the PDG code is in the set.
+ *
+ * Codes below the minimum wrap around and fail the size check, so a single
+ * comparison covers both bounds of the bitset.
+ */
+bool PdgSet::contains(PDG pdg) const
+{
+    if (!bits_.empty())
+    {
+        auto const i = static_cast<std::uint64_t>(
+            static_cast<std::int64_t>(pdg) - static_cast<std::int64_t>(min_));
+        return i / 64 < bits_.size() && (bits_[i / 64] >> (i % 64)) & 1;
+    }
+    return std::binary_search(sorted_.begin(), sorted_.end(), pdg);
+}
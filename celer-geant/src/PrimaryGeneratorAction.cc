@@ -6,45 +6,85 @@
 //---------------------------------------------------------------------------//
 #include "PrimaryGeneratorAction.hh"
 
-#include <G4ParticleGun.hh>
-#include <G4ParticleTable.hh>
-#include <G4SystemOfUnits.hh>
+#include <cstdint>
+#include <Randomize.hh>
 #include <corecel/Assert.hh>
 
-#include "DetectorConstruction.hh"
+#include "HepMC3Reader.hh"
 #include "JsonReader.hh"
+#include "RootIO.hh"
 
+namespace
+{
 //---------------------------------------------------------------------------//
 /*!
- * Generate primaries.
+ * Mix bits of a 64-bit integer (SplitMix64 finalizer).
  */
-void PrimaryGeneratorAction::GeneratePrimaries(G4Event* event)
+std::uint64_t mix_bits(std::uint64_t x)
 {
-    CELER_EXPECT(event);
-    auto const& json = JsonReader::Instance();
-    JsonReader::Validate(json, "particle_gun");
+    x += 0x9e3779b97f4a7c15ull;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Seed the thread-local Geant4 engine from a base seed and event ID.
+ */
+void seed_event(std::uint64_t seed, std::uint64_t event_id)
+{
+    auto const bits = mix_bits(mix_bits(seed) + event_id);
+    // Seeds must be positive and the list is zero-terminated
+    long seeds[3] = {static_cast<long>((bits & 0x7fffffff) | 1),
+                     static_cast<long>(((bits >> 32) & 0x7fffffff) | 1),
+                     0};
+    G4Random::setTheSeeds(seeds);
+}
 
-    auto const& pg = json.at("particle_gun");
-    JsonReader::Validate(pg, "pdg");
-    JsonReader::Validate(pg, "energy");
-    JsonReader::Validate(pg, "vertex");
-    JsonReader::Validate(pg, "direction");
+//---------------------------------------------------------------------------//
+}  // namespace
 
-    auto const pdg = pg.at("pdg").get<int>();
-    auto const energy = pg.at("energy").get<double>();
-    G4ThreeVector vertex(pg.at("vertex")[0].get<double>(),
-                         pg.at("vertex")[1].get<double>(),
-                         pg.at("vertex")[2].get<double>());
-    vertex *= cm;  // Convert to cm
-    G4ThreeVector direction(pg.at("direction")[0].get<double>(),
-                            pg.at("direction")[1].get<double>(),
-                            pg.at("direction")[2].get<double>());
+//---------------------------------------------------------------------------//
+/*!
+ * Construct thread-local primary source from the JSON particle gun input.
+ *
+ * The \c particle_gun key is validated by \c Config::Construct before the
+ * run starts.
+ */
+PrimaryGeneratorAction::PrimaryGeneratorAction()
+    : G4VUserPrimaryGeneratorAction(), seed_events_(RootIO::SeedEvents())
+{
+    if (!HepMC3Reader::Enabled())
+    {
+        source_ = std::make_unique<PrimarySource>(
+            JsonReader::Instance().at("particle_gun"));
+    }
+}
 
-    G4ParticleGun particle_gun;
-    particle_gun.SetParticleDefinition(
-        G4ParticleTable::GetParticleTable()->FindParticle(pdg));
-    particle_gun.SetParticleEnergy(energy);
-    particle_gun.SetParticlePosition(vertex);
-    particle_gun.SetParticleMomentumDirection(direction);
-    particle_gun.GeneratePrimaryVertex(event);
+//---------------------------------------------------------------------------//
+/*!
+ * Generate primaries.
+ */
+void PrimaryGeneratorAction::GeneratePrimaries(G4Event* event)
+{
+    CELER_EXPECT(event);
+    auto const sequence = event->GetEventID();
+    if (seed_events_)
+    {
+        // Skip events completed before a restart, and sample every event
+        // independently of which thread processes it and when
+        auto const id = RootIO::ResumedEvents().NthMissing(sequence);
+        event->SetEventID(id);
+        seed_event(RootIO::EventSeed(), id);
+    }
+    if (source_)
+    {
+        source_->GeneratePrimaryVertex(event);
+    }
+    else
+    {
+        // Read the record for this event, independently of the thread
+        HepMC3Reader::Instance().GeneratePrimaryVertex(sequence, event);
+    }
 }
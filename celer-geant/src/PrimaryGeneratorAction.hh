@@ -6,19 +6,35 @@
 //---------------------------------------------------------------------------//
 #pragma once
 
+#include <memory>
 #include <G4Event.hh>
 #include <G4VUserPrimaryGeneratorAction.hh>
 
+#include "PrimarySource.hh"
+
 //---------------------------------------------------------------------------//
 /*!
  * Generate primaries.
+ *
+ * The particle gun input is parsed once per worker thread into a
+ * \c PrimarySource , which is then sampled at every event. With
+ * \c "hepmc3" input, primaries are instead read from the shared
+ * \c HepMC3Reader .
+ *
+ * When checkpointing or resuming (see \c RootIO::SeedEvents ), every event
+ * is reseeded from its ID, and the events of a resumed run are relabeled
+ * with the IDs that are missing from the checkpoints.
  */
 class PrimaryGeneratorAction final : public G4VUserPrimaryGeneratorAction
 {
   public:
-    //! Construct empty
-    PrimaryGeneratorAction() = default;
+    //! Construct with JSON input data
+    PrimaryGeneratorAction();
 
     //! Place primaries in the event simulation
     void GeneratePrimaries(G4Event* event) final;
+
+  private:
+    std::unique_ptr<PrimarySource> source_;  // Null with HepMC3 input
+    bool seed_events_;
 };
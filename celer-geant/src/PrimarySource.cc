@@ -0,0 +1,261 @@
+//------------------------------- -*- C++ -*- -------------------------------//
+// Copyright Celeritas contributors: see top-level COPYRIGHT file for details
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+//---------------------------------------------------------------------------//
+//! \file celer-geant/src/PrimarySource.cc
+//---------------------------------------------------------------------------//
+#include "PrimarySource.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <G4ParticleTable.hh>
+#include <G4PhysicalConstants.hh>
+#include <G4SystemOfUnits.hh>
+#include <Randomize.hh>
+#include <corecel/Assert.hh>
+
+#include "JsonReader.hh"
+
+namespace
+{
+//---------------------------------------------------------------------------//
+/*!
+ * Load a three-vector from a JSON array.
+ */
+G4ThreeVector to_vector(nlohmann::json const& j, char const* name)
+{
+    CELER_VALIDATE(j.is_array() && j.size() == 3,
+                   << "\"" << name << "\" must be an array of size 3");
+    return G4ThreeVector(
+        j[0].get<double>(), j[1].get<double>(), j[2].get<double>());
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Build a normalized cumulative distribution from a list of weights.
+ */
+std::vector<double> make_cdf(std::vector<double> const& weights)
+{
+    CELER_VALIDATE(!weights.empty(), << "distribution weights are empty");
+    std::vector<double> result(weights.size());
+    double total = 0;
+    for (auto i = 0u; i < weights.size(); ++i)
+    {
+        CELER_VALIDATE(weights[i] >= 0,
+                       << "distribution weights must be nonnegative");
+        total += weights[i];
+        result[i] = total;
+    }
+    CELER_VALIDATE(total > 0, << "distribution weights sum to zero");
+    for (auto& c : result)
+    {
+        c /= total;
+    }
+    result.back() = 1;
+    return result;
+}
+//---------------------------------------------------------------------------//
+}  // namespace
+
+//---------------------------------------------------------------------------//
+/*!
+ * Construct from \c particle_gun JSON input.
+ */
+PrimarySource::PrimarySource(nlohmann::json const& input)
+{
+    JsonReader::Validate(input, "pdg");
+    JsonReader::Validate(input, "energy");
+    JsonReader::Validate(input, "vertex");
+    JsonReader::Validate(input, "direction");
+
+    auto const pdg = input.at("pdg").get<int>();
+    auto* pd = G4ParticleTable::GetParticleTable()->FindParticle(pdg);
+    CELER_VALIDATE(pd, << "PDG '" << pdg << "' not found in particle table");
+    gun_.SetParticleDefinition(pd);
+
+    this->BuildEnergy(input.at("energy"));
+    this->BuildVertex(input);
+    this->BuildDirection(input.at("direction"));
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Sample a primary and add it to the event.
+ */
+void PrimarySource::GeneratePrimaryVertex(G4Event* event)
+{
+    CELER_EXPECT(event);
+    if (energy_dist_ != EnergyDist::fixed)
+    {
+        gun_.SetParticleEnergy(this->SampleEnergy());
+    }
+    if (smear_vertex_)
+    {
+        gun_.SetParticlePosition(this->SampleVertex());
+    }
+    if (direction_dist_ != DirectionDist::fixed)
+    {
+        gun_.SetParticleMomentumDirection(this->SampleDirection());
+    }
+    gun_.GeneratePrimaryVertex(event);
+}
+
+//---------------------------------------------------------------------------//
+// PRIVATE
+//---------------------------------------------------------------------------//
+/*!
+ * Set up energy sampling [MeV].
+ */
+void PrimarySource::BuildEnergy(nlohmann::json const& j)
+{
+    if (j.is_number())
+    {
+        energy_dist_ = EnergyDist::fixed;
+        gun_.SetParticleEnergy(j.get<double>());
+        return;
+    }
+
+    JsonReader::Validate(j, "distribution");
+    JsonReader::Validate(j, "energies");
+    JsonReader::Validate(j, "weights");
+    auto const dist = j.at("distribution").get<std::string>();
+    energies_ = j.at("energies").get<std::vector<double>>();
+    energy_cdf_ = make_cdf(j.at("weights").get<std::vector<double>>());
+
+    if (dist == "discrete")
+    {
+        energy_dist_ = EnergyDist::discrete;
+        CELER_VALIDATE(energies_.size() == energy_cdf_.size(),
+                       << "discrete energy distribution must have one weight "
+                          "per energy");
+    }
+    else if (dist == "spectrum")
+    {
+        energy_dist_ = EnergyDist::spectrum;
+        CELER_VALIDATE(energies_.size() == energy_cdf_.size() + 1,
+                       << "energy spectrum must have one more bin edge than "
+                          "weights");
+        CELER_VALIDATE(std::is_sorted(energies_.begin(), energies_.end()),
+                       << "energy spectrum bin edges must be increasing");
+    }
+    else
+    {
+        CELER_VALIDATE(false,
+                       << "unknown energy distribution '" << dist
+                       << "' (expected \"discrete\" or \"spectrum\")");
+    }
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Set up vertex sampling [cm].
+ */
+void PrimarySource::BuildVertex(nlohmann::json const& input)
+{
+    vertex_ = to_vector(input.at("vertex"), "vertex") * cm;
+    gun_.SetParticlePosition(vertex_);
+
+    if (input.contains("beam_spot"))
+    {
+        auto const& j = input.at("beam_spot");
+        JsonReader::Validate(j, "sigma");
+        vertex_sigma_ = to_vector(j.at("sigma"), "sigma") * cm;
+        CELER_VALIDATE(vertex_sigma_.x() >= 0 && vertex_sigma_.y() >= 0
+                           && vertex_sigma_.z() >= 0,
+                       << "beam spot sigma must be nonnegative");
+        smear_vertex_ = vertex_sigma_.mag2() > 0;
+    }
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Set up direction sampling.
+ */
+void PrimarySource::BuildDirection(nlohmann::json const& j)
+{
+    if (j.is_array())
+    {
+        direction_dist_ = DirectionDist::fixed;
+        auto const dir = to_vector(j, "direction");
+        CELER_VALIDATE(dir.mag2() > 0, << "direction must be nonzero");
+        gun_.SetParticleMomentumDirection(dir.unit());
+        return;
+    }
+
+    JsonReader::Validate(j, "distribution");
+    auto const dist = j.at("distribution").get<std::string>();
+    if (dist == "isotropic")
+    {
+        direction_dist_ = DirectionDist::isotropic;
+        cos_min_ = -1;
+        axis_ = G4ThreeVector(0, 0, 1);
+    }
+    else if (dist == "cone")
+    {
+        direction_dist_ = DirectionDist::cone;
+        JsonReader::Validate(j, "axis");
+        JsonReader::Validate(j, "half_angle");
+        axis_ = to_vector(j.at("axis"), "axis");
+        CELER_VALIDATE(axis_.mag2() > 0, << "cone axis must be nonzero");
+        auto const half_angle = j.at("half_angle").get<double>() * deg;
+        CELER_VALIDATE(half_angle >= 0 && half_angle <= pi,
+                       << "cone half angle must be in [0, 180] degrees");
+        cos_min_ = std::cos(half_angle);
+    }
+    else
+    {
+        CELER_VALIDATE(false,
+                       << "unknown direction distribution '" << dist
+                       << "' (expected \"isotropic\" or \"cone\")");
+    }
+
+    // Orthonormal frame around the sampling axis
+    axis_ = axis_.unit();
+    axis_u_ = axis_.orthogonal().unit();
+    axis_v_ = axis_.cross(axis_u_);
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Sample energy from a precomputed cumulative distribution.
+ */
+double PrimarySource::SampleEnergy() const
+{
+    auto const u = G4UniformRand();
+    auto const bin
+        = std::upper_bound(energy_cdf_.begin(), energy_cdf_.end(), u)
+          - energy_cdf_.begin();
+    auto const i = std::min<size_t>(bin, energy_cdf_.size() - 1);
+    if (energy_dist_ == EnergyDist::discrete)
+    {
+        return energies_[i];
+    }
+    return energies_[i] + G4UniformRand() * (energies_[i + 1] - energies_[i]);
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Sample vertex from a Gaussian beam spot.
+ */
+G4ThreeVector PrimarySource::SampleVertex() const
+{
+    return G4ThreeVector(G4RandGauss::shoot(vertex_.x(), vertex_sigma_.x()),
+                         G4RandGauss::shoot(vertex_.y(), vertex_sigma_.y()),
+                         G4RandGauss::shoot(vertex_.z(), vertex_sigma_.z()));
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Sample direction uniformly within a cone around the sampling axis.
+ *
+ * Isotropic sampling is the special case of a cone with \f$ \cos\theta_{min}
+ * = -1 \f$.
+ */
+G4ThreeVector PrimarySource::SampleDirection() const
+{
+    double const cost = cos_min_ + (1 - cos_min_) * G4UniformRand();
+    double const sint = std::sqrt(std::max(0., 1 - cost * cost));
+    double const phi = twopi * G4UniformRand();
+    return sint * std::cos(phi) * axis_u_ + sint * std::sin(phi) * axis_v_
+           + cost * axis_;
+}
@@ -0,0 +1,36 @@
+//------------------------------- -*- C++ -*- -------------------------------//
+// Copyright Celeritas contributors: see top-level COPYRIGHT file for details
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+//---------------------------------------------------------------------------//
+//! \file celer-geant/src/Profiler.cc
+//---------------------------------------------------------------------------//
+#include "Profiler.hh"
+
+#include <utility>
+#include <G4Threading.hh>
+
+//---------------------------------------------------------------------------//
+/*!
+ * Return a thread-local instance.
+ */
+Profiler& Profiler::Instance()
+{
+    static thread_local Profiler instance;
+    return instance;
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Return the accumulated data and reset.
+ */
+ProfileData Profiler::Finalize()
+{
+    ProfileData result = std::move(data_);
+    data_ = {};
+    result.thread_id = G4Threading::G4GetThreadId();
+    if (result.num_events > 0)
+    {
+        result.run_time = seconds(first_event_, last_event_);
+    }
+    return result;
+}
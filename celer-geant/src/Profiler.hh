@@ -0,0 +1,229 @@
+//------------------------------- -*- C++ -*- -------------------------------//
+// Copyright Celeritas contributors: see top-level COPYRIGHT file for details
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+//---------------------------------------------------------------------------//
+//! \file celer-geant/src/Profiler.hh
+//---------------------------------------------------------------------------//
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <vector>
+
+#ifndef CELER_GEANT_PROFILING
+#    define CELER_GEANT_PROFILING 0
+#endif
+
+//---------------------------------------------------------------------------//
+/*!
+ * Code path through which steps are scored.
+ *
+ * Geant4 steps always go through the sensitive detector, while Celeritas
+ * steps go through it or through the batched step scorer depending on
+ * \c "step_scoring" .
+ */
+enum class ScoringPath
+{
+    sensitive_detector,  //!< SensitiveDetector::ProcessHits
+    batched,  //!< BatchedStepScorer::process_steps
+    size_
+};
+
+//---------------------------------------------------------------------------//
+/*!
+ * Time and throughput of a scoring path.
+ */
+struct ScoringProfile
+{
+    double time{0};  //!< Time spent in scoring calls
+    size_t num_calls{0};  //!< Steps or step batches passed to the path
+    size_t num_steps{0};  //!< Steps scored in a sensitive detector
+
+    //! Scored steps per second of scoring time
+    double steps_per_second() const { return time > 0 ? num_steps / time : 0; }
+};
+
+//---------------------------------------------------------------------------//
+/*!
+ * Performance counters and timers of a single worker thread.
+ *
+ * Times are wall-clock seconds.
+ */
+struct ProfileData
+{
+    using ArrScoring
+        = std::array<ScoringProfile, static_cast<size_t>(ScoringPath::size_)>;
+
+    int thread_id{-1};
+    size_t num_events{0};
+    double run_time{0};  //!< From first event begin to last event end
+    double event_time{0};  //!< Total time inside events
+    double max_event_time{0};  //!< Longest event
+    ArrScoring scoring;  //!< Indexed by ScoringPath
+    double flush_time{0};  //!< From empty Geant4 stack to end of event
+    size_t num_offloaded_tracks{0};  //!< Tracks handed to Celeritas
+    size_t num_kept_tracks{0};  //!< Tracks kept in Geant4 by the policy
+    size_t num_killed_tracks{0};  //!< Tracks killed instead of offloaded
+    std::vector<size_t> sd_hits;  //!< Scored steps per SD store index
+};
+
+//---------------------------------------------------------------------------//
+/*!
+ * Thread-local hot-path instrumentation.
+ *
+ * Profiling is enabled at compile time with the \c CELER_GEANT_PROFILING
+ * CMake option. Every call site is guarded by
+ * \code
+   if constexpr (Profiler::enabled())
+   {
+       Profiler::Instance().CountTrack(true);
+   }
+   \endcode
+ * so that a default build contains no instrumentation code at all.
+ *
+ * The Celeritas flush time is measured from the last
+ * \c G4UserStackingAction::NewStage of an event, which is when the Geant4
+ * stack is empty and the buffered offloaded tracks are transported, to the
+ * end of the event.
+ */
+class Profiler
+{
+  public:
+    //!@{
+    //! \name Type aliases
+    using Clock = std::chrono::steady_clock;
+    using TimePoint = Clock::time_point;
+    //!@}
+
+    //! Whether instrumentation is compiled in
+    static constexpr bool enabled() { return CELER_GEANT_PROFILING; }
+
+  public:
+    // Return a thread-local instance
+    static Profiler& Instance();
+
+    // Mark the beginning of an event
+    inline void BeginEvent();
+
+    //! Mark that the Geant4 stack of the current event is empty
+    void NewStage() { last_stage_ = Clock::now(); }
+
+    // Mark the end of an event
+    inline void EndEvent();
+
+    // Add the duration of a scoring call
+    inline void AddScoring(ScoringPath path, TimePoint start);
+
+    // Count a scored step in a sensitive detector
+    inline void CountHit(ScoringPath path, size_t sd_index);
+
+    //! Count a new track
+    void CountTrack(bool offloaded)
+    {
+        ++(offloaded ? data_.num_offloaded_tracks : data_.num_killed_tracks);
+    }
+
+    //! Count a track kept in Geant4 by the offload policy
+    void CountKeptTrack() { ++data_.num_kept_tracks; }
+
+    // Return the accumulated data and reset
+    ProfileData Finalize();
+
+  private:
+    ProfileData data_;
+    TimePoint first_event_;
+    TimePoint event_begin_;
+    TimePoint last_stage_;
+    TimePoint last_event_;
+
+    static double seconds(TimePoint begin, TimePoint end)
+    {
+        return std::chrono::duration<double>(end - begin).count();
+    }
+};
+
+//---------------------------------------------------------------------------//
+/*!
+ * Time a scoring call, such as \c SensitiveDetector::ProcessHits .
+ *
+ * This is empty unless profiling is compiled in.
+ */
+class ScopedScoringTimer
+{
+  public:
+    explicit ScopedScoringTimer(ScoringPath path) : path_(path)
+    {
+        if constexpr (Profiler::enabled())
+        {
+            start_ = Profiler::Clock::now();
+        }
+    }
+
+    ~ScopedScoringTimer()
+    {
+        if constexpr (Profiler::enabled())
+        {
+            Profiler::Instance().AddScoring(path_, start_);
+        }
+    }
+
+  private:
+    ScoringPath path_;
+    Profiler::TimePoint start_;
+};
+
+//---------------------------------------------------------------------------//
+// INLINE DEFINITIONS
+//---------------------------------------------------------------------------//
+/*!
+ * Mark the beginning of an event.
+ */
+void Profiler::BeginEvent()
+{
+    event_begin_ = Clock::now();
+    last_stage_ = event_begin_;
+    if (data_.num_events == 0)
+    {
+        first_event_ = event_begin_;
+    }
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Mark the end of an event.
+ */
+void Profiler::EndEvent()
+{
+    last_event_ = Clock::now();
+    double const event_time = seconds(event_begin_, last_event_);
+    data_.event_time += event_time;
+    data_.max_event_time = std::max(data_.max_event_time, event_time);
+    data_.flush_time += seconds(last_stage_, last_event_);
+    ++data_.num_events;
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Add the duration of a scoring call.
+ */
+void Profiler::AddScoring(ScoringPath path, TimePoint start)
+{
+    auto& scoring = data_.scoring[static_cast<size_t>(path)];
+    scoring.time += seconds(start, Clock::now());
+    ++scoring.num_calls;
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Count a scored step in a sensitive detector.
+ */
+void Profiler::CountHit(ScoringPath path, size_t sd_index)
+{
+    ++data_.scoring[static_cast<size_t>(path)].num_steps;
+    if (sd_index >= data_.sd_hits.size())
+    {
+        data_.sd_hits.resize(sd_index + 1);
+    }
+    ++data_.sd_hits[sd_index];
+}
@@ -8,25 +8,193 @@
 
 #include <corecel/Assert.hh>
 
+#include "Config.hh"
+
 //---------------------------------------------------------------------------//
 /*!
- * Add physical volume ID and copy number to the map and initialize histograms
- * associated to it.
+ * Add physical volume ID and copy number to the store.
+ *
+ * Placements inserted with the same name share a single \c SensDetData , so
+ * that replicated detectors can be scored into one set of histograms.
+ * Histograms are not allocated until the sensitive detector is touched.
  */
 void RootDataStore::InsertSensDet(PhysVolId pid,
                                   CopyNumber cid,
                                   std::string name)
 {
-    sensdet_map_.insert({{pid, cid}, SensDetData::Initialize(name)});
+    CELER_EXPECT(index_.empty());
+    auto [iter, inserted] = names_.insert({name, sensdets_.size()});
+    if (inserted)
+    {
+        SensDetData data;
+        data.sd_name = std::move(name);
+        sensdets_.push_back(std::move(data));
+    }
+    entries_.push_back({SensDetId{pid, cid}, iter->second});
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Build the dense (physical volume, copy number) lookup table and the
+ * scoring mesh tallies, sharing the histogram registry and meshes of
+ * \c Config .
+ *
+ * This must be called once, after all sensitive detectors are inserted.
+ */
+void RootDataStore::Initialize()
+{
+    CELER_EXPECT(index_.empty());
+    index_ = SensDetIndex(std::move(entries_));
+    entries_ = {};
+    names_ = {};
+
+    auto const& config = Config::Instance();
+    registry_ = config.histograms;
+    meshes_ = config.meshes;
+    for (auto const& mesh : *meshes_)
+    {
+        mesh_tallies_.push_back(mesh.MakeTally());
+    }
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Accumulate data from another thread's store.
+ *
+ * Every worker thread maps sensitive detectors from the same
+ * \c G4PhysicalVolumeStore , so both stores have the same layout.
+ */
+void RootDataStore::Merge(RootDataStore const& other)
+{
+    CELER_VALIDATE(sensdets_.size() == other.sensdets_.size(),
+                   << "cannot merge data stores with different numbers of "
+                      "sensitive detectors");
+    for (size_t i = 0; i < sensdets_.size(); ++i)
+    {
+        sensdets_[i].Merge(other.sensdets_[i]);
+    }
+    if (mesh_tallies_.size() < other.mesh_tallies_.size())
+    {
+        // Moved-from stores have no mesh tallies
+        mesh_tallies_.resize(other.mesh_tallies_.size());
+    }
+    for (size_t i = 0; i < other.mesh_tallies_.size(); ++i)
+    {
+        mesh_tallies_[i].Merge(other.mesh_tallies_[i]);
+    }
+    num_events_ += other.num_events_;
+    num_steps_ += other.num_steps_;
+    if (!registry_)
+    {
+        registry_ = other.registry_;
+    }
+    if (!meshes_)
+    {
+        meshes_ = other.meshes_;
+    }
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Copy accumulated data between events, reusing the target allocations.
+ *
+ * This is used to snapshot a live store for checkpointing: histograms that
+ * already exist in \c dst are assigned in place, so that copying into the
+ * same snapshot at every checkpoint does not reallocate dense bins. The
+ * lookup table is not copied, so \c dst can only be merged or written.
+ */
+void RootDataStore::CopyTo(RootDataStore* dst) const
+{
+    CELER_EXPECT(dst && dst != this);
+    CELER_EXPECT(touched_.empty());
+
+    dst->sensdets_.resize(sensdets_.size());
+    for (size_t i = 0; i < sensdets_.size(); ++i)
+    {
+        auto const& src_data = sensdets_[i];
+        auto& dst_data = dst->sensdets_[i];
+        dst_data.sd_name = src_data.sd_name;
+        dst_data.num_touched_events = src_data.num_touched_events;
+        if (!src_data.hists)
+        {
+            dst_data.hists.reset();
+        }
+        else if (dst_data.hists)
+        {
+            *dst_data.hists = *src_data.hists;
+        }
+        else
+        {
+            dst_data.hists
+                = std::make_unique<SensDetHistograms>(*src_data.hists);
+        }
+    }
+    dst->registry_ = registry_;
+    dst->meshes_ = meshes_;
+    dst->mesh_tallies_ = mesh_tallies_;
+    dst->num_events_ = num_events_;
+    dst->num_steps_ = num_steps_;
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Fill per-event histograms of SDs touched in this event and reset them.
+ *
+ * The bins filled during the event are folded into the per-event sums, so
+ * only the histograms of touched SDs, and only their filled bins, are
+ * visited. Scoring mesh voxels filled during the event are folded the same
+ * way.
+ */
+void RootDataStore::EndEvent()
+{
+    ObservableValues values;
+    for (auto idx : touched_)
+    {
+        auto& data = sensdets_[idx];
+        values[static_cast<size_t>(Observable::event_edep)] = data.total_edep;
+        values[static_cast<size_t>(Observable::event_num_steps)]
+            = data.num_steps;
+        registry_->FillEvent(values, data.hists.get());
+        data.hists->EndEvent();
+        num_steps_ += data.num_steps;
+        data.total_edep = 0;
+        data.num_steps = 0;
+        data.touched = false;
+        ++data.num_touched_events;
+    }
+    touched_.clear();
+    for (auto& tally : mesh_tallies_)
+    {
+        tally.EndEvent();
+    }
+    ++num_events_;
 }
 
 //---------------------------------------------------------------------------//
 /*!
- * Return data for a given sensitive detector.
+ * Account for events in which an SD was not touched.
+ *
+ * Every event contributes one entry per SD to the event histograms (e.g. the
+ * total energy deposition), so untouched events are added as zero entries. SDs
+ * that were never hit have no histograms and are skipped.
+ *
+ * This must be called after the stores of all threads are merged: a thread
+ * that never hit an SD has no histograms to fill, so its events would
+ * otherwise be missing from the merged event histograms of that SD. Filled
+ * events are counted as touched, so calling it again is a no-op.
  */
-SensDetData& RootDataStore::Find(PhysVolId pv_id, CopyNumber copy_num)
+void RootDataStore::FillUntouchedEvents()
 {
-    auto iter = sensdet_map_.find(SensDetId{pv_id, copy_num});
-    CELER_ASSERT(iter != sensdet_map_.end());
-    return iter->second;
+    CELER_EXPECT(touched_.empty());
+    for (auto& data : sensdets_)
+    {
+        if (!data.hists)
+        {
+            continue;
+        }
+        CELER_ASSERT(data.num_touched_events <= num_events_);
+        registry_->FillEmptyEvents(num_events_ - data.num_touched_events,
+                                   data.hists.get());
+        data.num_touched_events = num_events_;
+    }
 }
@@ -6,135 +6,85 @@
 //---------------------------------------------------------------------------//
 #pragma once
 
+#include <map>
+#include <memory>
 #include <string>
-#include <TH1D.h>
-#include <TH2D.h>
+#include <vector>
 #include <corecel/Assert.hh>
 
-#include "JsonReader.hh"
+#include "HistogramRegistry.hh"
+#include "ScoringMesh.hh"
+#include "SensDetIndex.hh"
 
 //---------------------------------------------------------------------------//
 /*!
  * Data storage container for sensitive detectors.
  *
- * This struct contains every object used by the ROOT I/O and it is constructed
- * for every sensitive detector found in the \c G4PhysicalVolumeStore .
+ * This struct is constructed for every sensitive detector group found in the
+ * \c G4PhysicalVolumeStore (see \c Config::aggregation ). Its histograms are
+ * only allocated when the SD is first hit, so memory scales with the activity
+ * in the geometry rather than its size.
  */
 struct SensDetData
 {
     std::string sd_name;  //!< Sensitive detector name
 
-    //!@{
-    //! ROOT histograms
-    TH1D energy_dep_x;  //!< Step energy deposition along x-axis
-    TH1D energy_dep_y;  //!< Step energy deposition along y-axis
-    TH1D energy_dep_z;  //!< Step energy deposition along z-axis
-    TH1D total_energy_dep;  //!< Total energy deposited in this SD
-    TH1D step_len;  //!< Step length
-    TH2D pos_xy;  //!< Pre-step position in (x, y) plane
-    TH1D time;  //!< Pre-step global time
-    TH1D costheta;  //!< Pre/post step direction dot product
-    //!@}
+    //! Histograms, allocated on first hit
+    std::unique_ptr<SensDetHistograms> hists;
 
     //!@{
-    //! User-defined data
+    //! Event observables
     // Accumulated at every step, used at ::EndOfEventAction to fill histogram
     double total_edep{};
+    size_t num_steps{};
+    //!@}
+
+    //!@{
+    //! Event bookkeeping
+    bool touched{false};  //!< Whether this SD was hit in the current event
+    size_t num_touched_events{0};  //!< Number of events that hit this SD
     //!@}
 
-    //! Initialize histograms using the SD name and JSON input data
-    static SensDetData Initialize(std::string sd_name)
+    //! Accumulate data of the same SD from another thread
+    void Merge(SensDetData const& other)
     {
-        // Local helper struct for initializing histograms
-        struct HistDef
+        CELER_EXPECT(sd_name == other.sd_name);
+        num_touched_events += other.num_touched_events;
+        if (!other.hists)
         {
-            size_t nbins;
-            double min;
-            double max;
-        };
-
-        // Populate HistDef object from JSON (used by 1D and 2D histograms)
-        auto from_json
-            = [](nlohmann::json const& j, std::string name) -> HistDef {
-            JsonReader::ValidateHistogram(j, name.c_str());
-            HistDef hist_def;
-            auto const& jh = j.at(name);
-            hist_def.nbins = jh.at("num_bins").get<size_t>();
-            hist_def.min = jh.at("min").get<double>();
-            hist_def.max = jh.at("max").get<double>();
-            return hist_def;
-        };
-
-        JsonReader::Validate(JsonReader::Instance(), "histograms");
-        auto const& json_hist = JsonReader::Instance().at("histograms");
-
-#define SDD_INIT_TH1D(HIST)                                                  \
-    {                                                                        \
-        std::string htitle = sd_name + "_" + #HIST;                          \
-        auto const hd = from_json(json_hist, #HIST);                         \
-        result.HIST = TH1D(#HIST, htitle.c_str(), hd.nbins, hd.min, hd.max); \
-        result.HIST.AddDirectory(false);                                     \
-    }
-#define SDD_INIT_TH2D(HIST)                                   \
-    {                                                         \
-        std::string htitle = sd_name + "_" + #HIST;           \
-        auto const hdx = from_json(json_hist.at(#HIST), "x"); \
-        auto const hdy = from_json(json_hist.at(#HIST), "y"); \
-        result.HIST = TH2D(#HIST,                             \
-                           htitle.c_str(),                    \
-                           hdx.nbins,                         \
-                           hdx.min,                           \
-                           hdx.max,                           \
-                           hdy.nbins,                         \
-                           hdy.min,                           \
-                           hdy.max);                          \
-        result.HIST.AddDirectory(false);                      \
-    }
-
-        //// Initialie histograms ////
-        SensDetData result;
-        result.sd_name = sd_name;
-        SDD_INIT_TH1D(energy_dep_x)
-        SDD_INIT_TH1D(energy_dep_y)
-        SDD_INIT_TH1D(energy_dep_z)
-        SDD_INIT_TH1D(total_energy_dep)
-        SDD_INIT_TH1D(step_len)
-        SDD_INIT_TH2D(pos_xy)
-        SDD_INIT_TH1D(time)
-        SDD_INIT_TH1D(costheta)
-        return result;
-
-#undef SDD_INIT_TH1D
-#undef SDD_INIT_TH2D
+            return;
+        }
+        if (!hists)
+        {
+            hists = std::make_unique<SensDetHistograms>(*other.hists);
+            return;
+        }
+        hists->Merge(*other.hists);
     }
 };
 
-//---------------------------------------------------------------------------//
-/*!
- * Helper struct for indexing physical volumes to an object.
- * (e.g. std::map<SensDetId, SensDetData> map)
- */
-struct SensDetId
-{
-    size_t physvol_id;
-    size_t copy_number;
-};
-
-//---------------------------------------------------------------------------//
-//! Overload \c operator< for \c map.find(sensdetid) compatibility.
-inline bool operator<(SensDetId const& lhs, SensDetId const& rhs)
-{
-    return std::make_tuple(lhs.physvol_id, lhs.copy_number)
-           < std::make_tuple(rhs.physvol_id, rhs.copy_number);
-}
-
 //---------------------------------------------------------------------------//
 /*!
  * ROOT I/O data storage manager class.
  *
  * This class stores a \c SensDetData for every sensitive detector in
  * the geometry and allows an easy way to access them using the physical volume
- * instance ID and copy number.
+ * instance ID and copy number. Several placements may map onto the same
+ * \c SensDetData when they are inserted with the same name.
+ *
+ * Sensitive detectors are inserted once and then \c Initialize creates a
+ * dense \c SensDetIndex so that \c Find is a constant-time array lookup, and
+ * compiles the \c HistogramRegistry whose empty histograms are copied when
+ * an SD is first touched.
+ *
+ * The store also keeps a list of sensitive detectors touched during the
+ * current event, so that per-event bookkeeping in \c EndEvent only costs as
+ * much as the number of SDs actually hit. Events that did not touch an SD are
+ * accounted for by \c FillUntouchedEvents once the stores of all threads are
+ * merged.
+ *
+ * Scoring meshes are independent of sensitive detectors: every step is
+ * scored into a dense \c MeshTally per mesh, allocated in \c Initialize .
  */
 class RootDataStore
 {
@@ -143,20 +93,153 @@ class RootDataStore
     //! \name Type aliases
     using PhysVolId = size_t;
     using CopyNumber = size_t;
+    using VecSensDetData = std::vector<SensDetData>;
     //!@}
 
     //! Construct empty
     RootDataStore() = default;
 
-    //! Map and initialize histograms for a sensitive detector
+    //! Map a sensitive detector placement to the data named \c name
     void InsertSensDet(PhysVolId pv_id, CopyNumber copy_num, std::string name);
 
+    //! Build lookup table and histogram registry after SDs are inserted
+    void Initialize();
+
+    //! Accumulate data from another thread's store
+    void Merge(RootDataStore const& other);
+
+    //! Copy accumulated data between events, reusing the target allocations
+    void CopyTo(RootDataStore* dst) const;
+
+    //! Accumulate event counts restored from a checkpoint
+    void AddCounts(size_t num_events, size_t num_steps)
+    {
+        num_events_ += num_events;
+        num_steps_ += num_steps;
+    }
+
     //! Get histogram data for a given physical volume ID and copy number
-    SensDetData& Find(PhysVolId pv_id, CopyNumber copy_num);
+    inline SensDetData& Find(PhysVolId pv_id, CopyNumber copy_num);
+
+    //! Get histogram data and mark the SD as touched in the current event
+    inline SensDetData& Touch(PhysVolId pv_id, CopyNumber copy_num);
+
+    //! Fill per-event histograms of touched SDs and reset them
+    void EndEvent();
+
+    //! Indices of SDs touched in the current event
+    std::vector<size_t> const& Touched() const { return touched_; }
+
+    //! Account for events in which an SD was not touched
+    void FillUntouchedEvents();
+
+    //! Number of events processed by this store
+    size_t NumEvents() const { return num_events_; }
+
+    //! Number of steps scored by this store
+    size_t NumSteps() const { return num_steps_; }
+
+    //! Score a step in every scoring mesh
+    inline void ScoreMeshes(ScoringMesh::Real3 const& pre,
+                            ScoringMesh::Real3 const& post,
+                            double edep,
+                            double step_len);
+
+    //! Whether any scoring mesh is declared
+    bool HasMeshes() const { return !mesh_tallies_.empty(); }
 
-    //! Access full SD map
-    std::map<SensDetId, SensDetData>& Map() { return sensdet_map_; }
+    //! Scoring meshes, empty if none are declared
+    ScoringMesh::VecMesh const& Meshes() const
+    {
+        static ScoringMesh::VecMesh const empty;
+        return meshes_ ? *meshes_ : empty;
+    }
+
+    //! Tallies of each scoring mesh
+    std::vector<MeshTally>& MeshTallies() { return mesh_tallies_; }
+
+    //! Tallies of each scoring mesh (const)
+    std::vector<MeshTally> const& MeshTallies() const
+    {
+        return mesh_tallies_;
+    }
+
+    //! Histogram declarations and fill plan
+    HistogramRegistry const& Registry() const
+    {
+        CELER_EXPECT(registry_);
+        return *registry_;
+    }
+
+    //! Access all SD data
+    VecSensDetData& SensDets() { return sensdets_; }
+
+    //! Access all SD data (const)
+    VecSensDetData const& SensDets() const { return sensdets_; }
 
   private:
-    std::map<SensDetId, SensDetData> sensdet_map_;
+    VecSensDetData sensdets_;
+    std::vector<SensDetIndex::Entry> entries_;
+    std::map<std::string, size_t> names_;
+    SensDetIndex index_;
+    std::shared_ptr<HistogramRegistry const> registry_;
+    std::shared_ptr<ScoringMesh::VecMesh const> meshes_;
+    std::vector<MeshTally> mesh_tallies_;
+    std::vector<size_t> touched_;
+    size_t num_events_{0};
+    size_t num_steps_{0};
 };
+
+//---------------------------------------------------------------------------//
+// INLINE DEFINITIONS
+//---------------------------------------------------------------------------//
+/*!
+ * Return data for a given sensitive detector.
+ */
+SensDetData& RootDataStore::Find(PhysVolId pv_id, CopyNumber copy_num)
+{
+    auto const idx = index_.Find(pv_id, copy_num);
+    CELER_ASSERT(idx < sensdets_.size());
+    return sensdets_[idx];
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Return data for a given sensitive detector and mark it as touched.
+ *
+ * The SD histograms are guaranteed to be allocated.
+ */
+SensDetData& RootDataStore::Touch(PhysVolId pv_id, CopyNumber copy_num)
+{
+    auto const idx = index_.Find(pv_id, copy_num);
+    CELER_ASSERT(idx < sensdets_.size());
+    auto& data = sensdets_[idx];
+    if (!data.touched)
+    {
+        if (CELER_UNLIKELY(!data.hists))
+        {
+            // Allocate histograms on first hit
+            data.hists = std::make_unique<SensDetHistograms>(
+                registry_->Prototype());
+        }
+        data.touched = true;
+        touched_.push_back(idx);
+    }
+    return data;
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Score a step in every scoring mesh.
+ */
+void RootDataStore::ScoreMeshes(ScoringMesh::Real3 const& pre,
+                                ScoringMesh::Real3 const& post,
+                                double edep,
+                                double step_len)
+{
+    CELER_EXPECT(meshes_ && meshes_->size() == mesh_tallies_.size());
+    for (size_t i = 0; i < mesh_tallies_.size(); ++i)
+    {
+        (*meshes_)[i].Score(pre, post, edep, step_len, &mesh_tallies_[i]);
+    }
+}
@@ -6,15 +6,29 @@
 //---------------------------------------------------------------------------//
 #include "RootIO.hh"
 
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <vector>
 #include <G4LogicalVolume.hh>
 #include <G4PhysicalVolumeStore.hh>
 #include <G4Threading.hh>
 #include <G4VSensitiveDetector.hh>
+#include <TFile.h>
+#include <TH3D.h>
 #include <TROOT.h>
 #include <TTree.h>
 #include <corecel/Assert.hh>
 #include <corecel/io/Logger.hh>
 
+#include "Calibration.hh"
+#include "HistogramWriter.hh"
+#include "HybridTrackingManager.hh"
 #include "JsonReader.hh"
 
 namespace
@@ -29,17 +43,243 @@ auto root_enable_thread_safety = []() -> int {
     ROOT::EnableThreadSafety();
     return 0;
 }();
+
+//---------------------------------------------------------------------------//
+//! Data stores handed over by worker threads at the end of the run.
+std::vector<RootDataStore> worker_stores;
+//! Profiling data handed over by worker threads at the end of the run.
+std::vector<ProfileData> worker_profiles;
+std::mutex worker_stores_mutex;
+
+//---------------------------------------------------------------------------//
+//! Instance of this thread, reset at the end of every run.
+thread_local std::unique_ptr<RootIO> thread_instance;
+
+//---------------------------------------------------------------------------//
+/*!
+ * Merge data stores in place with a parallel pairwise tree reduction.
+ *
+ * At each level, store \c i accumulates store \c i+stride on its own thread,
+ * so \c N stores are reduced in \c log2(N) levels. The result is stored in
+ * the first element. Exceptions thrown by a merge are rethrown here.
+ */
+void tree_reduce(std::vector<RootDataStore>& stores)
+{
+    for (size_t stride = 1; stride < stores.size(); stride *= 2)
+    {
+        std::vector<std::future<void>> merges;
+        for (size_t i = 0; i + stride < stores.size(); i += 2 * stride)
+        {
+            merges.push_back(
+                std::async(std::launch::async, [&stores, i, stride] {
+                    stores[i].Merge(stores[i + stride]);
+                    stores[i + stride] = {};
+                }));
+        }
+        for (auto& m : merges)
+        {
+            m.get();
+        }
+    }
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Log the scoring throughput of each path, summed over worker threads.
+ *
+ * Geant4 steps are always scored by \c ProcessHits , so a batched run
+ * reports both paths side by side.
+ */
+void log_scoring_profile(std::vector<ProfileData> const& profiles)
+{
+    char const* const path_name[] = {"ProcessHits", "batched scorer"};
+    for (size_t i = 0; i < static_cast<size_t>(ScoringPath::size_); ++i)
+    {
+        ScoringProfile total;
+        for (auto const& p : profiles)
+        {
+            total.time += p.scoring[i].time;
+            total.num_calls += p.scoring[i].num_calls;
+            total.num_steps += p.scoring[i].num_steps;
+        }
+        if (total.num_calls == 0)
+        {
+            continue;
+        }
+        CELER_LOG(info) << "Scoring with " << path_name[i] << ": "
+                        << total.num_steps << " steps in " << total.num_calls
+                        << " calls, " << total.time << " s ("
+                        << total.steps_per_second() << " steps/s)";
+    }
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Write scoring mesh tallies as \c TH3D in \c meshes/[name] directories.
+ *
+ * As with histograms, voxel errors are estimated from the per-event sums, and
+ * normalized meshes are divided by the number of events.
+ */
+void write_meshes(TFile& file,
+                  RootDataStore const& data_store,
+                  size_t num_events)
+{
+    auto const& meshes = data_store.Meshes();
+    auto const& tallies = data_store.MeshTallies();
+    for (size_t m = 0; m < meshes.size(); ++m)
+    {
+        auto const& mesh = meshes[m];
+        auto const& tally = tallies[m];
+        if (tally.edep.empty())
+        {
+            continue;
+        }
+        std::string const dir_name = "meshes/" + mesh.name();
+        file.mkdir(dir_name.c_str())->cd();
+
+        bool const cyl = mesh.geometry() == ScoringMesh::Geometry::cylindrical;
+        auto const& x = mesh.axis(0);
+        auto const& y = mesh.axis(1);
+        auto const& z = mesh.axis(2);
+        auto write = [&](char const* name, MeshTally::VecBin const& bins) {
+            TH3D h(name,
+                   (mesh.name() + "_" + name).c_str(),
+                   x.num_bins,
+                   x.min,
+                   x.max,
+                   y.num_bins,
+                   y.min,
+                   y.max,
+                   z.num_bins,
+                   z.min,
+                   z.max);
+            h.SetDirectory(nullptr);
+            h.SetXTitle(cyl ? "r [cm]" : "x [cm]");
+            h.SetYTitle(cyl ? "phi [deg]" : "y [cm]");
+            h.SetZTitle("z [cm]");
+            for (size_t k = 0; k < z.num_bins; ++k)
+            {
+                for (size_t j = 0; j < y.num_bins; ++j)
+                {
+                    for (size_t i = 0; i < x.num_bins; ++i)
+                    {
+                        auto const& bin = bins[mesh.Index(i, j, k)];
+                        auto const cell = h.GetBin(i + 1, j + 1, k + 1);
+                        h.SetBinContent(cell, bin.sum_w);
+                        h.SetBinError(cell, event_error(bin, num_events));
+                    }
+                }
+            }
+            if (mesh.normalize())
+            {
+                h.Scale(1. / num_events);
+            }
+            h.Write();
+        };
+        write("edep", tally.edep);
+        write("track_length", tally.track_length);
+    }
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Append thread ID to a filename, replacing its extension.
+ */
+std::string thread_filename(std::string const& filename,
+                            std::string const& ext = ".root")
+{
+    std::string result = filename.substr(0, filename.find_last_of("."));
+    result += "-" + std::to_string(G4Threading::G4GetThreadId()) + ext;
+    return result;
+}
+
+//---------------------------------------------------------------------------//
+//! Checkpointed data loaded by a resumed run.
+std::unique_ptr<Checkpoint> resumed_checkpoint;
+//! Base seed of per-event random number seeds.
+std::uint64_t event_seed{0};
+
+//---------------------------------------------------------------------------//
+/*!
+ * Remove the extension of a filename.
+ */
+std::string file_stem(std::string const& filename)
+{
+    return filename.substr(0, filename.find_last_of("."));
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Find the per-thread and resumed checkpoint files of a checkpoint filename.
+ *
+ * For \c "checkpoint.root" these are \c "checkpoint-[thread].root" and
+ * \c "checkpoint-resumed.root" .
+ */
+std::vector<std::string> find_checkpoint_files(std::string const& filename)
+{
+    namespace fs = std::filesystem;
+
+    fs::path const stem = file_stem(filename);
+    auto const dir = stem.has_parent_path() ? stem.parent_path()
+                                            : fs::path(".");
+    auto const prefix = stem.filename().string() + "-";
+    std::string const ext = ".root";
+
+    std::vector<std::string> result;
+    if (!fs::is_directory(dir))
+    {
+        return result;
+    }
+    for (auto const& entry : fs::directory_iterator(dir))
+    {
+        auto const name = entry.path().filename().string();
+        if (name.size() <= prefix.size() + ext.size()
+            || name.compare(0, prefix.size(), prefix) != 0
+            || entry.path().extension() != ext)
+        {
+            continue;
+        }
+        auto const suffix = name.substr(
+            prefix.size(), name.size() - prefix.size() - ext.size());
+        bool const is_thread
+            = std::all_of(suffix.begin(), suffix.end(), [](unsigned char c) {
+                  return std::isdigit(c);
+              });
+        if (is_thread || suffix == "resumed")
+        {
+            result.push_back(entry.path().string());
+        }
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
 //---------------------------------------------------------------------------//
 }  // namespace
 
 //---------------------------------------------------------------------------//
 /*!
- * Return the static thread-local singleton instance.
+ * Return the thread-local singleton instance, constructing it if needed.
  */
 RootIO* RootIO::Instance()
 {
-    static thread_local RootIO instance;
-    return &instance;
+    if (CELER_UNLIKELY(!thread_instance))
+    {
+        thread_instance.reset(new RootIO);
+    }
+    return thread_instance.get();
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Destroy the thread-local instance after it is finalized.
+ *
+ * Task-based run managers reuse pool threads across runs, so the next run
+ * on this thread constructs a new instance from the current geometry.
+ */
+void RootIO::Reset()
+{
+    thread_instance.reset();
 }
 
 //---------------------------------------------------------------------------//
@@ -55,27 +295,13 @@ RootIO::RootIO()
     CELER_VALIDATE(G4Threading::IsWorkerThread(),
                    << "Must be constructed on worker thread");
 
-    auto const& json = JsonReader::Instance();
-    JsonReader::Validate(json, "root_output");
-    auto const filename = json.at("root_output").get<std::string>();
-    CELER_VALIDATE(!filename.empty(), << "ROOT filename must be non-empty");
-
-    // Append thread ID to filename
-    std::string thread_filename
-        = filename.substr(0, filename.find_last_of("."));
-    thread_filename += "-" + std::to_string(G4Threading::G4GetThreadId())
-                       + ".root";
-
-    CELER_LOG_LOCAL(status) << "Open file " << thread_filename;
-    file_ = TFile::Open(thread_filename.c_str(), "recreate");
-    CELER_VALIDATE(!file_->IsZombie(),
-                   << "ROOT file \"" << thread_filename << "\" is zombie");
-
     // Map physical volumes to be scored
     auto const& physvol_store = *G4PhysicalVolumeStore::GetInstance();
     CELER_ASSERT(!physvol_store.empty());
 
     CELER_LOG_LOCAL(status) << "Mapping sensitive detectors for I/O";
+    auto const aggregation = Config::Instance().aggregation;
+    size_t num_placements = 0;
     for (auto const& physvol : physvol_store)
     {
         CELER_ASSERT(physvol);
@@ -91,81 +317,658 @@ RootIO::RootIO()
         auto const name = sd->GetName();
         auto const pid = physvol->GetInstanceID();
         auto const copy_num = physvol->GetCopyNo();
-        std::string str_pid_copynum = std::to_string(pid) + "_"
-                                      + std::to_string(copy_num);
-        std::string sd_name = name + "_" + str_pid_copynum;
+        CELER_VALIDATE(copy_num >= 0,
+                       << "sensitive physical volume \""
+                       << physvol->GetName() << "\" has negative copy number "
+                       << copy_num
+                       << ", which cannot be indexed for scoring");
+        std::string sd_name;
+        switch (aggregation)
+        {
+            case ScoringAggregation::placement:
+                sd_name = name + "_" + std::to_string(pid) + "_"
+                          + std::to_string(copy_num);
+                break;
+            case ScoringAggregation::logical_volume:
+                sd_name = name + "_" + logvol->GetName();
+                break;
+            case ScoringAggregation::sensitive_detector:
+                sd_name = name;
+                break;
+        }
         data_store_.InsertSensDet(pid, copy_num, sd_name);
+        ++num_placements;
 
         CELER_LOG(debug) << "Mapped " << name << " with instance ID " << pid
                          << " and copy number " << copy_num
                          << " as sensitive detector";
     }
 
-    CELER_VALIDATE(!data_store_.Map().empty(),
-                   << "No sensitive detectors mapped. Geometry has no "
-                      "\"SensDet\" auxiliary data or RootIO::Instance() was "
-                      "called before ::BeginOfRunAction.");
+    // Scoring meshes alone are enough for a run without sensitive volumes
+    CELER_VALIDATE(!data_store_.SensDets().empty()
+                       || Config::Instance().HasMeshes(),
+                   << "No sensitive detectors mapped and no scoring meshes. "
+                      "Geometry has no \"SensDet\" auxiliary data or "
+                      "RootIO::Instance() was called before "
+                      "::BeginOfRunAction.");
+    CELER_LOG_LOCAL(debug) << "Mapped " << num_placements
+                           << " sensitive placements onto "
+                           << data_store_.SensDets().size()
+                           << " histogram groups";
+
+    // Build dense lookup table used by SensitiveDetector::ProcessHits
+    data_store_.Initialize();
+
+    auto const& json = JsonReader::Instance();
+    if (json.contains("event_output"))
+    {
+        // Start asynchronous per-event output
+        auto const& j = json.at("event_output");
+        JsonReader::Validate(j, "filename");
+        auto const capacity = j.contains("queue_capacity")
+                                  ? j.at("queue_capacity").get<size_t>()
+                                  : 256;
+        std::vector<std::string> sd_names;
+        for (auto const& data : data_store_.SensDets())
+        {
+            sd_names.push_back(data.sd_name);
+        }
+        event_writer_ = std::make_unique<EventWriter>(
+            thread_filename(j.at("filename").get<std::string>()),
+            std::move(sd_names),
+            capacity);
+    }
+
+    if (json.contains("step_records"))
+    {
+        // Start memory-mapped step output for offline rescoring
+        auto const& j = json.at("step_records");
+        JsonReader::Validate(j, "filename");
+        std::vector<std::string> sd_names;
+        for (auto const& data : data_store_.SensDets())
+        {
+            sd_names.push_back(data.sd_name);
+        }
+        step_records_ = std::make_unique<StepRecordWriter>(
+            thread_filename(j.at("filename").get<std::string>(), ".steps"),
+            sd_names);
+    }
+
+    if (json.contains("checkpoint"))
+    {
+        // Start periodic checkpoints of this thread's data
+        auto const& j = json.at("checkpoint");
+        JsonReader::Validate(j, "filename");
+        auto get = [&j](char const* key, auto default_value) {
+            return j.contains(key) ? j.at(key).get<decltype(default_value)>()
+                                   : default_value;
+        };
+        checkpoint_ = std::make_unique<CheckpointWriter>(
+            thread_filename(j.at("filename").get<std::string>()),
+            get("events", size_t{0}),
+            get("seconds", double{0}),
+            RootIO::EventSeed());
+    }
 
     CELER_LOG_LOCAL(status) << "Past validate";
 }
 
 //---------------------------------------------------------------------------//
 /*!
- * Write Celeritas Output Registry diagnostics as a string during
+ * Write the optional per-event row and finish the event in the store.
+ *
+ * The row is handed to the \c EventWriter thread, so this does not wait for
+ * ROOT compression or disk I/O.
+ */
+void RootIO::EndEvent(int event_id)
+{
+    if (event_writer_)
+    {
+        auto row = event_writer_->AcquireRow();
+        row.event_id = event_id;
+        auto const& sensdets = data_store_.SensDets();
+        for (auto idx : data_store_.Touched())
+        {
+            row.sd_index.push_back(idx);
+            row.edep.push_back(sensdets[idx].total_edep);
+            row.num_steps.push_back(sensdets[idx].num_steps);
+        }
+        event_writer_->Push(std::move(row));
+    }
+    if (step_records_)
+    {
+        step_records_->EndEvent();
+    }
+    data_store_.EndEvent();
+
+    if (checkpoint_)
+    {
+        events_.Insert(event_id);
+        checkpoint_->EndEvent(data_store_, events_);
+    }
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Store Celeritas Output Registry diagnostics as a string during
  * \c RunAction::EndOfRunAction:: .
  *
+ * This is only written to the per-thread output file.
+ *
  * \note Since this is on a worker thread the diagnostics has no record of the
  * total simulation runtime.
  */
 void RootIO::StoreDiagnostics(std::string diagnostics)
 {
-    char const* name = "diagnostics";
-    TTree tree(name, name, this->SplitLevel(), nullptr);
-    tree.Branch(name, &diagnostics);
-    tree.Fill();
-    tree.Write();
+    diagnostics_ = std::move(diagnostics);
 }
 
 //---------------------------------------------------------------------------//
 /*!
- * Finalize I/O by writing data to thread-local ROOT file and close it.
+ * Hand over thread-local data to the master thread.
+ *
+ * If \c "root_output_per_thread" is enabled, the thread-local data is also
+ * written to its own ROOT file.
  */
 void RootIO::Finalize()
 {
-#define RIO_HIST_WRITE(MEMBER) data.MEMBER.Write();
-#define RIO_HIST_NORMALIZE_AND_WRITE(MEMBER) \
-    {                                        \
-        data.MEMBER.Scale(1. / num_events);  \
-        data.MEMBER.Write();                 \
+    if (event_writer_)
+    {
+        // Flush remaining events
+        event_writer_->Close();
+        event_writer_.reset();
+    }
+    if (checkpoint_)
+    {
+        // Finish the last checkpoint
+        checkpoint_->Close();
+        checkpoint_.reset();
+    }
+    if (step_records_)
+    {
+        // Complete the header and release the mapping
+        step_records_->Close();
+        step_records_.reset();
     }
 
-    // Used for normalization
-    auto const num_events = JsonReader::Instance()
-                                .at("particle_gun")
-                                .at("num_events")
-                                .get<size_t>();
+    std::vector<ProfileData> profiles;
+    if constexpr (Profiler::enabled())
+    {
+        profiles.push_back(Profiler::Instance().Finalize());
+    }
 
-    std::string const hist_folder = "histograms/";
+    if (Config::Instance().root_output_per_thread)
+    {
+        // Zero-fill a copy: the handed-over store is filled after the merge
+        RootDataStore thread_store;
+        data_store_.CopyTo(&thread_store);
+        thread_store.FillUntouchedEvents();
+        RootIO::Write(thread_filename(Config::Instance().root_output),
+                      thread_store,
+                      std::move(diagnostics_),
+                      profiles);
+    }
 
-    for (auto& [ids, data] : data_store_.Map())
+    std::lock_guard<std::mutex> lock(worker_stores_mutex);
+    worker_stores.push_back(std::move(data_store_));
+    data_store_ = {};
+    for (auto& p : profiles)
     {
-        std::string dir_name = hist_folder + data.sd_name;
-        auto hist_sd_dir = file_->mkdir(dir_name.c_str());
-        hist_sd_dir->cd();
+        worker_profiles.push_back(std::move(p));
+    }
+}
 
-        RIO_HIST_NORMALIZE_AND_WRITE(energy_dep_x)
-        RIO_HIST_NORMALIZE_AND_WRITE(energy_dep_y)
-        RIO_HIST_NORMALIZE_AND_WRITE(energy_dep_z)
-        RIO_HIST_WRITE(total_energy_dep)
-        RIO_HIST_WRITE(step_len)
-        RIO_HIST_WRITE(pos_xy)
-        RIO_HIST_WRITE(time)
-        RIO_HIST_WRITE(costheta)
+//---------------------------------------------------------------------------//
+/*!
+ * Merge all worker data on the master thread and write a single ROOT file.
+ *
+ * This must be called during the master \c RunAction::EndOfRunAction , which
+ * Geant4 invokes after every worker thread has finished its run. The wall
+ * time of the event loop is used to report the step scoring throughput.
+ */
+void RootIO::FinalizeMaster(std::string diagnostics, double run_time)
+{
+    CELER_VALIDATE(G4Threading::IsMasterThread(),
+                   << "Must be called on master thread");
+
+    std::vector<RootDataStore> stores;
+    std::vector<ProfileData> profiles;
+    {
+        std::lock_guard<std::mutex> lock(worker_stores_mutex);
+        stores = std::move(worker_stores);
+        worker_stores = {};
+        profiles = std::move(worker_profiles);
+        worker_profiles = {};
+    }
+    CELER_VALIDATE(!stores.empty(), << "No worker data to merge");
+
+    if (resumed_checkpoint)
+    {
+        // Add data of the interrupted run
+        auto const& sensdets = stores.front().SensDets();
+        auto const& resumed = resumed_checkpoint->store.SensDets();
+        CELER_VALIDATE(sensdets.size() == resumed.size(),
+                       << "checkpoint has " << resumed.size()
+                       << " sensitive detectors but the geometry has "
+                       << sensdets.size());
+        for (size_t i = 0; i < sensdets.size(); ++i)
+        {
+            CELER_VALIDATE(sensdets[i].sd_name == resumed[i].sd_name,
+                           << "checkpoint sensitive detector '"
+                           << resumed[i].sd_name << "' does not match '"
+                           << sensdets[i].sd_name << "'");
+        }
+        stores.push_back(std::move(resumed_checkpoint->store));
+        resumed_checkpoint->store = {};
+    }
+
+    CELER_LOG(status) << "Merging data from " << stores.size()
+                      << " worker threads";
+    tree_reduce(stores);
+
+    auto& merged = stores.front();
+    merged.FillUntouchedEvents();
+    CELER_LOG(info) << "Scored " << merged.NumSteps() << " steps in "
+                    << merged.NumEvents() << " events during a " << run_time
+                    << " s event loop ("
+                    << (run_time > 0 ? merged.NumSteps() / run_time : 0)
+                    << " steps/s)";
+    if (!profiles.empty())
+    {
+        log_scoring_profile(profiles);
+    }
+
+    if (Config::Instance().offload_policy.enabled())
+    {
+        auto const counts = HybridTrackingManager::Totals();
+        CELER_LOG(info) << "Offload policy: " << counts.offloaded
+                        << " tracks offloaded, " << counts.below_energy
+                        << " below energy threshold and "
+                        << counts.outside_region
+                        << " outside regions kept in Geant4";
+    }
+
+    RootIO::Write(Config::Instance().root_output,
+                  merged,
+                  std::move(diagnostics),
+                  profiles);
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Load checkpoints on the master thread and return the completed events.
+ *
+ * With \c "resume" set to the checkpoint filename of an interrupted run, the
+ * per-thread checkpoints of that run (and of the run it resumed, if any) are
+ * merged. The remaining events are then simulated with the same event IDs
+ * and seeds they would have had without the interruption.
+ *
+ * If the resumed run writes checkpoints too, the merged data is saved to
+ * \c "[checkpoint]-resumed.root" first and the loaded per-thread files with
+ * the same name are removed, so that the next checkpoints of the resumed run
+ * and that file together describe every completed event.
+ *
+ * This must be called before \c BeamOn . It returns zero if the run is not
+ * resumed.
+ */
+size_t RootIO::Resume()
+{
+    CELER_VALIDATE(G4Threading::IsMasterThread(),
+                   << "Must be called on master thread");
+
+    auto const& json = JsonReader::Instance();
+    if (json.contains("checkpoint") && json.at("checkpoint").contains("seed"))
+    {
+        event_seed = json.at("checkpoint").at("seed").get<std::uint64_t>();
+    }
+    if (!json.contains("resume"))
+    {
+        return 0;
+    }
+
+    auto const filename = json.at("resume").get<std::string>();
+    auto const files = find_checkpoint_files(filename);
+    CELER_VALIDATE(!files.empty(),
+                   << "no checkpoint files found for \"" << filename
+                   << "\"");
+
+    auto result = std::make_unique<Checkpoint>(Checkpoint::Read(files[0]));
+    for (size_t i = 1; i < files.size(); ++i)
+    {
+        auto other = Checkpoint::Read(files[i]);
+        CELER_VALIDATE(other.seed == result->seed,
+                       << "checkpoint file \"" << files[i]
+                       << "\" was written with a different event seed");
+        result->store.Merge(other.store);
+        result->events.Merge(other.events);
+    }
+    CELER_ASSERT(result->store.NumEvents() == result->events.size());
+
+    auto const num_events = Config::Instance().num_events;
+    CELER_VALIDATE(result->events.empty()
+                       || result->events.ranges().back().second
+                              <= num_events,
+                   << "checkpoint contains events beyond the " << num_events
+                   << " requested events");
+    CELER_VALIDATE(result->events.size() < num_events,
+                   << "checkpoint already contains all " << num_events
+                   << " events");
+    if (event_seed != result->seed)
+    {
+        CELER_LOG(warning) << "Using event seed " << result->seed
+                           << " of the checkpoint instead of " << event_seed;
+        event_seed = result->seed;
+    }
+    CELER_LOG(info) << "Resuming after " << result->events.size() << " of "
+                    << num_events << " events from " << files.size()
+                    << " checkpoint files";
+
+    if (json.contains("checkpoint"))
+    {
+        // Save the merged data before new checkpoints replace thread files
+        auto const new_filename
+            = json.at("checkpoint").at("filename").get<std::string>();
+        auto const resumed_filename
+            = file_stem(new_filename) + "-resumed.root";
+        result->Write(resumed_filename);
+        for (auto const& f : find_checkpoint_files(new_filename))
+        {
+            if (std::find(files.begin(), files.end(), f) != files.end()
+                && std::filesystem::path(f)
+                       != std::filesystem::path(resumed_filename))
+            {
+                std::remove(f.c_str());
+            }
+        }
+    }
+
+    resumed_checkpoint = std::move(result);
+    return resumed_checkpoint->events.size();
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Events completed by the checkpoints of a resumed run.
+ *
+ * This is empty if the run is not resumed.
+ */
+EventRanges const& RootIO::ResumedEvents()
+{
+    static EventRanges const empty;
+    return resumed_checkpoint ? resumed_checkpoint->events : empty;
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Whether every event is seeded from its ID for checkpointing.
+ *
+ * Geant4 seeds events in the order they are dispatched, so a resumed run can
+ * only reproduce the missing events of an interrupted run if both runs seed
+ * events from their IDs instead.
+ */
+bool RootIO::SeedEvents()
+{
+    auto const& json = JsonReader::Instance();
+    return json.contains("checkpoint") || json.contains("resume");
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Base seed of per-event random number seeds.
+ *
+ * This is the optional \c "seed" of the \c "checkpoint" JSON input, or the
+ * seed of the resumed checkpoint.
+ */
+std::uint64_t RootIO::EventSeed()
+{
+    return event_seed;
+}
+
+//---------------------------------------------------------------------------//
+// PRIVATE
+//---------------------------------------------------------------------------//
+/*!
+ * Write data store, diagnostics, and profiling to a new ROOT file.
+ */
+void RootIO::Write(std::string const& filename,
+                   RootDataStore const& data_store,
+                   std::string diagnostics,
+                   std::vector<ProfileData> const& profiles)
+{
+    CELER_VALIDATE(!filename.empty(), << "ROOT filename must be non-empty");
+    CELER_LOG_LOCAL(status) << "Open file " << filename;
+    std::unique_ptr<TFile> file(TFile::Open(filename.c_str(), "recreate"));
+    CELER_VALIDATE(file && !file->IsZombie(),
+                   << "ROOT file \"" << filename << "\" is zombie");
+
+    if (!diagnostics.empty())
+    {
+        file->cd();
+        char const* name = "diagnostics";
+        TTree tree(name, name, RootIO::SplitLevel(), nullptr);
+        tree.Branch(name, &diagnostics);
+        tree.Fill();
+        tree.Write();
+    }
+
+    if (!profiles.empty())
+    {
+        file->cd();
+        RootIO::WriteProfiles(profiles, data_store);
+    }
+
+    if (!Calibration::Candidates().empty())
+    {
+        file->cd();
+        RootIO::WriteCalibration();
+    }
+
+    if (Config::Instance().offload_policy.enabled()
+        && G4Threading::IsMasterThread())
+    {
+        // Counters are only complete for the whole run
+        file->cd();
+        RootIO::WriteOffloadPolicy();
+    }
+
+    // Used for normalization and errors: events actually scored by this
+    // store, which differs from the requested count for per-thread output
+    // and aborted or resumed runs
+    auto const num_events = data_store.NumEvents();
+
+    auto const num_skipped = write_histograms(
+        *file, data_store.SensDets(), data_store.Registry(), num_events);
+    write_meshes(*file, data_store, num_events);
+
+    if (num_skipped > 0)
+    {
+        CELER_LOG_LOCAL(info) << "Skipped " << num_skipped << " of "
+                              << data_store.SensDets().size()
+                              << " sensitive detectors that were never hit";
     }
     CELER_LOG_LOCAL(info) << "Wrote Geant4 ROOT output to \""
-                          << file_->GetName() << "\"";
-    file_->Close();
+                          << file->GetName() << "\"";
+    file->Close();
+}
 
-#undef RIO_HIST_WRITE
-#undef RIO_HIST_NORMALIZE_AND_WRITE
+//---------------------------------------------------------------------------//
+/*!
+ * Write profiling data of worker threads to the current ROOT directory.
+ *
+ * The \c "performance" tree has one entry per worker thread, with the time,
+ * number of calls, scored steps, and throughput of each scoring path
+ * (\c sd_ for \c ProcessHits and \c batched_ for the batched step scorer).
+ * The \c "performance_hits" tree has one entry per thread and sensitive
+ * detector with the number of scored steps.
+ */
+void RootIO::WriteProfiles(std::vector<ProfileData> const& profiles,
+                           RootDataStore const& data_store)
+{
+    constexpr auto num_paths = static_cast<size_t>(ScoringPath::size_);
+    char const* const path_prefix[num_paths] = {"sd_", "batched_"};
+
+    {
+        TTree tree("performance", "performance", RootIO::SplitLevel());
+        ProfileData row;
+        ULong64_t num_events{};
+        ULong64_t num_offloaded_tracks{};
+        ULong64_t num_kept_tracks{};
+        ULong64_t num_killed_tracks{};
+        double events_per_second{};
+        double mean_event_time{};
+        ULong64_t num_scoring_calls[num_paths]{};
+        ULong64_t num_scored_steps[num_paths]{};
+        double scoring_steps_per_second[num_paths]{};
+        tree.Branch("thread_id", &row.thread_id);
+        tree.Branch("num_events", &num_events);
+        tree.Branch("run_time", &row.run_time);
+        tree.Branch("events_per_second", &events_per_second);
+        tree.Branch("event_time", &row.event_time);
+        tree.Branch("mean_event_time", &mean_event_time);
+        tree.Branch("max_event_time", &row.max_event_time);
+        for (size_t i = 0; i < num_paths; ++i)
+        {
+            std::string const prefix = path_prefix[i];
+            tree.Branch((prefix + "scoring_time").c_str(),
+                        &row.scoring[i].time);
+            tree.Branch((prefix + "scoring_calls").c_str(),
+                        &num_scoring_calls[i]);
+            tree.Branch((prefix + "scored_steps").c_str(),
+                        &num_scored_steps[i]);
+            tree.Branch((prefix + "steps_per_second").c_str(),
+                        &scoring_steps_per_second[i]);
+        }
+        tree.Branch("flush_time", &row.flush_time);
+        tree.Branch("num_offloaded_tracks", &num_offloaded_tracks);
+        tree.Branch("num_kept_tracks", &num_kept_tracks);
+        tree.Branch("num_killed_tracks", &num_killed_tracks);
+        for (auto const& p : profiles)
+        {
+            row = p;
+            num_events = p.num_events;
+            num_offloaded_tracks = p.num_offloaded_tracks;
+            num_kept_tracks = p.num_kept_tracks;
+            num_killed_tracks = p.num_killed_tracks;
+            events_per_second = p.run_time > 0 ? p.num_events / p.run_time
+                                               : 0;
+            mean_event_time = p.num_events > 0 ? p.event_time / p.num_events
+                                                : 0;
+            for (size_t i = 0; i < num_paths; ++i)
+            {
+                num_scoring_calls[i] = p.scoring[i].num_calls;
+                num_scored_steps[i] = p.scoring[i].num_steps;
+                scoring_steps_per_second[i] = p.scoring[i].steps_per_second();
+            }
+            tree.Fill();
+
+            CELER_LOG(debug) << "Thread " << p.thread_id << ": "
+                             << p.num_events << " events, "
+                             << events_per_second << " events/s, "
+                             << p.scoring[0].time + p.scoring[1].time
+                             << " s scoring, " << p.flush_time
+                             << " s flushing";
+        }
+        tree.Write();
+    }
+
+    {
+        TTree tree("performance_hits", "performance_hits");
+        Int_t thread_id{};
+        std::string sd_name;
+        ULong64_t num_hits{};
+        tree.Branch("thread_id", &thread_id);
+        tree.Branch("sd_name", &sd_name);
+        tree.Branch("num_hits", &num_hits);
+        auto const& sensdets = data_store.SensDets();
+        for (auto const& p : profiles)
+        {
+            thread_id = p.thread_id;
+            CELER_ASSERT(p.sd_hits.size() <= sensdets.size());
+            for (size_t i = 0; i < p.sd_hits.size(); ++i)
+            {
+                if (p.sd_hits[i] == 0)
+                {
+                    continue;
+                }
+                sd_name = sensdets[i].sd_name;
+                num_hits = p.sd_hits[i];
+                tree.Fill();
+            }
+        }
+        tree.Write();
+    }
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Write Celeritas capacity calibration to the current ROOT directory.
+ *
+ * The \c "calibration" tree has one entry per measured candidate, and the
+ * \c "celeritas_capacity" tree has a single entry with the selected
+ * capacities used by the run.
+ */
+void RootIO::WriteCalibration()
+{
+    {
+        TTree tree("calibration", "calibration");
+        ULong64_t max_num_tracks{};
+        ULong64_t initializer_capacity{};
+        ULong64_t max_initializers{};
+        bool success{};
+        double steps_per_second{};
+        tree.Branch("max_num_tracks", &max_num_tracks);
+        tree.Branch("initializer_capacity", &initializer_capacity);
+        tree.Branch("success", &success);
+        tree.Branch("steps_per_second", &steps_per_second);
+        tree.Branch("max_initializers", &max_initializers);
+        for (auto const& c : Calibration::Candidates())
+        {
+            max_num_tracks = c.max_num_tracks;
+            initializer_capacity = c.initializer_capacity;
+            success = c.success;
+            steps_per_second = c.steps_per_second;
+            max_initializers = c.max_initializers;
+            tree.Fill();
+        }
+        tree.Write();
+    }
+
+    {
+        auto const& json = JsonReader::Instance().at("celeritas");
+        TTree tree("celeritas_capacity", "celeritas_capacity");
+        ULong64_t max_num_tracks = json.at("max_num_tracks").get<size_t>();
+        ULong64_t initializer_capacity
+            = json.at("initializer_capacity").get<size_t>();
+        tree.Branch("max_num_tracks", &max_num_tracks);
+        tree.Branch("initializer_capacity", &initializer_capacity);
+        tree.Fill();
+        tree.Write();
+    }
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Write hybrid offload policy counters to the current ROOT directory.
+ *
+ * The \c "offload_policy" tree has a single entry with the policy and the
+ * number of tracks of offloaded particle types handed to each path.
+ */
+void RootIO::WriteOffloadPolicy()
+{
+    auto const& policy = Config::Instance().offload_policy;
+    auto const counts = HybridTrackingManager::Totals();
+
+    TTree tree("offload_policy", "offload_policy");
+    double min_energy = policy.min_energy;
+    std::vector<std::string> regions = policy.regions;
+    ULong64_t offloaded = counts.offloaded;
+    ULong64_t below_energy = counts.below_energy;
+    ULong64_t outside_region = counts.outside_region;
+    tree.Branch("min_energy", &min_energy);
+    tree.Branch("regions", &regions);
+    tree.Branch("offloaded", &offloaded);
+    tree.Branch("below_energy", &below_energy);
+    tree.Branch("outside_region", &outside_region);
+    tree.Fill();
+    tree.Write();
 }
@@ -6,9 +6,17 @@
 //---------------------------------------------------------------------------//
 #pragma once
 
-#include <TFile.h>
+#include <cstdint>
+#include <memory>
+#include <string>
 
+#include "Checkpoint.hh"
+#include "Config.hh"
+#include "EventRanges.hh"
+#include "EventWriter.hh"
+#include "Profiler.hh"
 #include "RootDataStore.hh"
+#include "StepRecordFile.hh"
 
 //---------------------------------------------------------------------------//
 /*!
@@ -23,6 +31,36 @@
  * a given sensitive detector can be done by accumulating the total energy
  * during \c ProcessHits  and the final tally written to a histogram at
  * \c G4UserEventAction::EndOfEventAction .
+ *
+ * At the end of the run every worker hands its data store over to the master
+ * thread, which merges them in a parallel tree reduction and writes a single
+ * ROOT file. The thread-local instance is then destroyed, so that a pool
+ * thread reused by a later run (e.g. with the tasking run manager) starts
+ * from a fresh instance. Setting \c "root_output_per_thread" to \c true in
+ * the JSON input additionally writes one file per worker (with the thread ID
+ * appended to the filename) for debugging.
+ *
+ * The optional \c "scoring_aggregation" JSON input selects whether histograms
+ * are kept per \c "placement" , per \c "logical_volume" , or per
+ * \c "sensitive_detector" name. Aggregated placements share a single
+ * accumulator, so per-event quantities such as the total energy deposition
+ * are summed over every placement in the group.
+ *
+ * The optional \c "event_output" JSON input additionally writes one row per
+ * event with the energy deposition and number of steps of every touched SD,
+ * using an asynchronous \c EventWriter per worker thread.
+ *
+ * The optional \c "step_records" JSON input writes every scored step to a
+ * memory-mapped \c StepRecordWriter file per worker thread, which
+ * \c celer-geant-rescore replays through new histogram declarations.
+ *
+ * The optional \c "checkpoint" JSON input periodically saves every worker's
+ * data store with a \c CheckpointWriter , and \c "resume" restarts a killed
+ * run from those checkpoints: only the events missing from the checkpoints
+ * are simulated, and the checkpointed data is merged into the final output.
+ *
+ * When built with \c CELER_GEANT_PROFILING , the \c Profiler data of every
+ * worker is written to \c "performance" trees next to the diagnostics.
  */
 class RootIO
 {
@@ -30,26 +68,70 @@ class RootIO
     //! Return a thread-local singleton instance
     static RootIO* Instance();
 
+    //! Destroy the thread-local instance after it is finalized
+    static void Reset();
+
     //! Get reference to thread-local data
     RootDataStore& Data() { return data_store_; }
 
-    //! Store OutputRegistry diagnostics
+    //! Step record output, or null if disabled
+    StepRecordWriter* StepRecords() { return step_records_.get(); }
+
+    //! Write the optional per-event row and finish the event in the store
+    void EndEvent(int event_id);
+
+    //! Store OutputRegistry diagnostics for the per-thread output
     void StoreDiagnostics(std::string diagnostics);
 
-    //! Write data to ROOT file and close it
+    //! Hand over thread-local data to the master thread
     void Finalize();
 
+    //! Merge all worker data on the master thread and write output
+    static void FinalizeMaster(std::string diagnostics, double run_time);
+
+    //! Load checkpoints on the master thread and return the completed events
+    static size_t Resume();
+
+    //! Events completed by the checkpoints of a resumed run
+    static EventRanges const& ResumedEvents();
+
+    //! Whether every event is seeded from its ID for checkpointing
+    static bool SeedEvents();
+
+    //! Base seed of per-event random number seeds
+    static std::uint64_t EventSeed();
+
   private:
     //// DATA ////
 
-    TFile* file_;
     RootDataStore data_store_;
+    std::string diagnostics_;
+    std::unique_ptr<EventWriter> event_writer_;
+    EventRanges events_;  //!< Events completed by this thread
+    std::unique_ptr<CheckpointWriter> checkpoint_;
+    std::unique_ptr<StepRecordWriter> step_records_;
 
     //// HELPER FUNCTIONS ////
 
     // Construct with JSON input filename on worker thread
     RootIO();
 
+    // Write data store, diagnostics, and profiling to a new ROOT file
+    static void Write(std::string const& filename,
+                      RootDataStore const& data_store,
+                      std::string diagnostics,
+                      std::vector<ProfileData> const& profiles);
+
+    // Write profiling data of worker threads
+    static void WriteProfiles(std::vector<ProfileData> const& profiles,
+                              RootDataStore const& data_store);
+
+    // Write Celeritas capacity calibration
+    static void WriteCalibration();
+
+    // Write hybrid offload policy counters
+    static void WriteOffloadPolicy();
+
     // ROOT TTree split level
     static constexpr short int SplitLevel() { return 99; }
 };
@@ -6,6 +6,7 @@
 //---------------------------------------------------------------------------//
 #include "RunAction.hh"
 
+#include <sstream>
 #include <G4Threading.hh>
 #include <accel/ExceptionConverter.hh>
 #include <accel/TrackingManagerIntegration.hh>
@@ -13,16 +14,70 @@
 #include <corecel/io/Logger.hh>
 #include <corecel/io/OutputRegistry.hh>
 
+#include "BatchedStepScorer.hh"
+#include "Calibration.hh"
+#include "Config.hh"
 #include "RootIO.hh"
 
+namespace
+{
+//---------------------------------------------------------------------------//
+/*!
+ * Reject scoring filters that cannot be evaluated for offloaded tracks.
+ *
+ * Celeritas reconstructs the \c G4Track of each step it sends to a
+ * sensitive detector without a creator process, so a \c "processes" filter
+ * would score every offloaded step as if it came from a primary. Batched
+ * step scoring validates its own filters, since it can select primaries.
+ */
+void validate_offload_filters()
+{
+    if (BatchedStepScorer::Enabled())
+    {
+        return;
+    }
+
+    auto const& config = Config::Instance();
+    auto validate = [](std::string const& name, ScoringFilter const& filter) {
+        CELER_VALIDATE(!filter.SelectsCreator(),
+                       << "scoring filter of '" << name
+                       << "' selects creator processes, which are not "
+                          "available for tracks offloaded to Celeritas "
+                          "with sensitive detector scoring");
+    };
+    validate("default", config.default_filter);
+    for (auto const& [sd_name, filter] : config.filters)
+    {
+        validate(sd_name, filter);
+    }
+}
+
+//---------------------------------------------------------------------------//
+}  // namespace
+
 //---------------------------------------------------------------------------//
 /*!
  * Initialize master and worker threads in Celeritas.
+ *
+ * When tracks are offloaded, scoring filters are validated on the master
+ * thread before any event is simulated.
  */
 void RunAction::BeginOfRunAction(G4Run const* run)
 {
     CELER_LOG_LOCAL(status) << "Begin of run action";
-    celeritas::TrackingManagerIntegration::Instance().BeginOfRunAction(run);
+    auto& tmi = celeritas::TrackingManagerIntegration::Instance();
+    tmi.BeginOfRunAction(run);
+
+    if (G4Threading::IsMasterThread()
+        && tmi.GetMode() == celeritas::OffloadMode::enabled)
+    {
+        CELER_TRY_HANDLE(validate_offload_filters(),
+                         celeritas::ExceptionConverter{"celer-geant."
+                                                       "beginrun"});
+    }
+
+    // Time the event loop, excluding Celeritas setup
+    run_timer_ = {};
 
     if (G4Threading::IsWorkerThread())
     {
@@ -37,25 +92,50 @@ void RunAction::BeginOfRunAction(G4Run const* run)
 
 //---------------------------------------------------------------------------//
 /*!
- * Write thread-local ROOT file and return Celeritas to an invalid state.
+ * Merge and write ROOT output and return Celeritas to an invalid state.
+ *
+ * Workers hand their data over to the master thread, whose end of run action
+ * is called after all workers are done.
  */
 void RunAction::EndOfRunAction(G4Run const* run)
 {
     using Mode = celeritas::OffloadMode;
 
+    double const run_time = run_timer_();
     auto& tmi = celeritas::TrackingManagerIntegration::Instance();
+
+    // Celeritas diagnostics to be written to ROOT file
+    auto get_diagnostics = [&tmi]() -> std::string {
+        std::ostringstream diagnostics;
+        if (tmi.GetMode() == Mode::enabled)
+        {
+            tmi.GetParams().output_reg()->output(&diagnostics);
+        }
+        return diagnostics.str();
+    };
+
     if (G4Threading::IsWorkerThread())
     {
         auto* rio = RootIO::Instance();
-        if (tmi.GetMode() == Mode::enabled)
+        if (Config::Instance().root_output_per_thread)
         {
-            // Write Celeritas diagnostics to ROOT file
-            std::ostringstream diagnostics;
-            tmi.GetParams().output_reg()->output(&diagnostics);
-            rio->StoreDiagnostics(diagnostics.str());
+            rio->StoreDiagnostics(get_diagnostics());
         }
-        // Write and close ROOT output
+        // Hand thread-local data over to the master thread
         rio->Finalize();
+        // Pool threads may be reused by a later run
+        RootIO::Reset();
+    }
+    else
+    {
+        // Merge worker data and write a single ROOT output
+        CELER_TRY_HANDLE(RootIO::FinalizeMaster(get_diagnostics(), run_time),
+                         celeritas::ExceptionConverter{"celer-geant."
+                                                       "endrun"});
+        if (Calibration::IsWarmup())
+        {
+            Calibration::WriteWarmup(run_time);
+        }
     }
     // Return Celeritas to an invalid state
     tmi.EndOfRunAction(run);
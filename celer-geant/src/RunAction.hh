@@ -7,6 +7,7 @@
 #pragma once
 
 #include <G4UserRunAction.hh>
+#include <corecel/sys/Stopwatch.hh>
 
 //---------------------------------------------------------------------------//
 /*!
@@ -23,4 +24,7 @@ class RunAction : public G4UserRunAction
 
     //! Finalize I/O and Celeritas offloading interface
     void EndOfRunAction(G4Run const* run) final;
+
+  private:
+    celeritas::Stopwatch run_timer_;
 };
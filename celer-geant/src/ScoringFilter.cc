@@ -0,0 +1,104 @@
+//------------------------------- -*- C++ -*- -------------------------------//
+// Copyright Celeritas contributors: see top-level COPYRIGHT file for details
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+//---------------------------------------------------------------------------//
+//! \file celer-geant/src/ScoringFilter.cc
+//---------------------------------------------------------------------------//
+#include "ScoringFilter.hh"
+
+#include <algorithm>
+#include <G4SystemOfUnits.hh>
+#include <corecel/Assert.hh>
+
+#include "JsonReader.hh"
+
+namespace
+{
+//---------------------------------------------------------------------------//
+/*!
+ * Load a [min, max] window from a JSON array.
+ */
+void load_window(nlohmann::json const& j,
+                 char const* name,
+                 double unit,
+                 double* min,
+                 double* max)
+{
+    auto const window = j.at(name).get<std::vector<double>>();
+    CELER_VALIDATE(window.size() == 2,
+                   << "scoring filter \"" << name
+                   << "\" must be a [min, max] array");
+    CELER_VALIDATE(window[0] <= window[1],
+                   << "scoring filter \"" << name << "\" window ["
+                   << window[0] << ", " << window[1] << "] is invalid");
+    *min = window[0] * unit;
+    *max = window[1] * unit;
+}
+//---------------------------------------------------------------------------//
+}  // namespace
+
+//---------------------------------------------------------------------------//
+/*!
+ * Offloaded particles, which are the default scored particles.
+ *
+ * If \c "offload_particles" is not set, it defaults to the Celeritas basic EM
+ * list.
+ */
+PdgSet ScoringFilter::OffloadPdgs()
+{
+    JsonReader::Validate(JsonReader::Instance(), "celeritas");
+    auto const& json = JsonReader::Instance().at("celeritas");
+    if (json.contains("offload_particles"))
+    {
+        return PdgSet(json.at("offload_particles").get<std::vector<PDG>>());
+    }
+    return PdgSet({11, -11, 22});
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Construct from a filter JSON entry.
+ */
+ScoringFilter::ScoringFilter(nlohmann::json const& input)
+{
+    CELER_VALIDATE(input.is_object(),
+                   << "scoring filter must be a JSON object");
+
+    pdgs_ = input.contains("pdgs")
+                ? PdgSet(input.at("pdgs").get<std::vector<PDG>>())
+                : ScoringFilter::OffloadPdgs();
+    CELER_VALIDATE(!pdgs_.empty(), << "scoring filter \"pdgs\" is empty");
+
+    if (input.contains("energy"))
+    {
+        load_window(input, "energy", MeV, &min_energy_, &max_energy_);
+    }
+    if (input.contains("time"))
+    {
+        load_window(input, "time", ns, &min_time_, &max_time_);
+    }
+    if (input.contains("processes"))
+    {
+        processes_ = input.at("processes").get<VecString>();
+        auto iter = std::find(processes_.begin(), processes_.end(), "primary");
+        if (iter != processes_.end())
+        {
+            accept_primary_ = true;
+            processes_.erase(iter);
+        }
+    }
+}
+
+//---------------------------------------------------------------------------//
+// PRIVATE
+//---------------------------------------------------------------------------//
+/*!
+ * Whether tracks created by this process are scored.
+ */
+bool ScoringFilter::AcceptProcess(G4VProcess const* process) const
+{
+    CELER_EXPECT(process);
+    auto const& name = process->GetProcessName();
+    return std::find(processes_.begin(), processes_.end(), name)
+           != processes_.end();
+}
@@ -0,0 +1,157 @@
+//------------------------------- -*- C++ -*- -------------------------------//
+// Copyright Celeritas contributors: see top-level COPYRIGHT file for details
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+//---------------------------------------------------------------------------//
+//! \file celer-geant/src/ScoringFilter.hh
+//---------------------------------------------------------------------------//
+#pragma once
+
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <G4Step.hh>
+#include <G4Track.hh>
+#include <G4VProcess.hh>
+#include <corecel/Assert.hh>
+#include <nlohmann/json.hpp>
+
+#include "PdgSet.hh"
+
+//---------------------------------------------------------------------------//
+/*!
+ * Per sensitive detector step filter.
+ *
+ * Filters are defined in the optional \c "scoring_filters" JSON block, with a
+ * \c "default" entry used by every sensitive detector that has no entry of
+ * its own:
+ * \code
+   "scoring_filters": {
+       "default": {"pdgs": [11, -11, 22]},
+       "sd_gap": {"pdgs": [22],
+                  "energy": [0.01, 1000],
+                  "time": [0, 10],
+                  "processes": ["primary", "compt"]}
+   }
+   \endcode
+ *
+ * - \c "pdgs" : scored particles (default: \c "offload_particles" ).
+ * - \c "energy" : pre-step kinetic energy window [MeV].
+ * - \c "time" : pre-step global time window [ns].
+ * - \c "processes" : creator process names of scored tracks, where
+ *   \c "primary" selects primary tracks. Tracks offloaded to Celeritas are
+ *   rebuilt without a creator process, so with sensitive detector scoring
+ *   this is rejected unless offloading is disabled (e.g. the Geant4
+ *   reference run of a comparison).
+ *
+ * Every predicate is compiled once, into \c Config , and they are evaluated
+ * from cheapest to most expensive so that rejected steps return before any
+ * histogram is touched. Each sensitive detector copies its filter, whose
+ * creator process decisions are cached per process pointer, so string
+ * comparisons only happen once per process and thread.
+ */
+class ScoringFilter
+{
+  public:
+    //!@{
+    //! \name Type aliases
+    using PDG = int;
+    using VecString = std::vector<std::string>;
+    //!@}
+
+  public:
+    // Offloaded particles, which are the default scored particles
+    static PdgSet OffloadPdgs();
+
+    //! Construct empty, rejecting every step
+    ScoringFilter() = default;
+
+    // Construct from a filter JSON entry
+    explicit ScoringFilter(nlohmann::json const& input);
+
+    // Whether the step should be scored
+    inline bool operator()(G4Step const& step) const;
+
+    // Whether a step with these pre-step properties should be scored
+    inline bool Accept(PDG pdg, double energy, double time) const;
+
+    //! Whether tracks are selected by creator process name
+    bool HasCreatorProcesses() const { return !processes_.empty(); }
+
+    //! Whether tracks are selected by creator process or as primaries
+    bool SelectsCreator() const
+    {
+        return this->HasCreatorProcesses() || accept_primary_;
+    }
+
+    //! Whether a track passes a filter without creator process names
+    bool AcceptTrack(bool is_primary) const
+    {
+        CELER_EXPECT(!this->HasCreatorProcesses());
+        return !accept_primary_ || is_primary;
+    }
+
+  private:
+    using ProcessCache = std::unordered_map<G4VProcess const*, bool>;
+
+    PdgSet pdgs_;
+    double min_energy_{0};
+    double max_energy_{std::numeric_limits<double>::infinity()};
+    double min_time_{-std::numeric_limits<double>::infinity()};
+    double max_time_{std::numeric_limits<double>::infinity()};
+    VecString processes_;
+    bool accept_primary_{false};
+    mutable ProcessCache process_cache_;
+
+    // Whether tracks created by this process are scored
+    bool AcceptProcess(G4VProcess const* process) const;
+};
+
+//---------------------------------------------------------------------------//
+// INLINE DEFINITIONS
+//---------------------------------------------------------------------------//
+/*!
+ * Whether the step should be scored.
+ */
+bool ScoringFilter::operator()(G4Step const& step) const
+{
+    auto const* track = step.GetTrack();
+    auto const* pre = step.GetPreStepPoint();
+    if (!this->Accept(track->GetParticleDefinition()->GetPDGEncoding(),
+                      pre->GetKineticEnergy(),
+                      pre->GetGlobalTime()))
+    {
+        return false;
+    }
+
+    if (processes_.empty() && !accept_primary_)
+    {
+        return true;
+    }
+
+    auto const* process = track->GetCreatorProcess();
+    if (!process)
+    {
+        return accept_primary_;
+    }
+    auto iter = process_cache_.find(process);
+    if (iter == process_cache_.end())
+    {
+        iter = process_cache_
+                   .insert({process, this->AcceptProcess(process)})
+                   .first;
+    }
+    return iter->second;
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Whether a step with these pre-step properties should be scored.
+ *
+ * Energy and time are in Geant4 units.
+ */
+bool ScoringFilter::Accept(PDG pdg, double energy, double time) const
+{
+    return pdgs_.contains(pdg) && energy >= min_energy_
+           && energy <= max_energy_ && time >= min_time_ && time <= max_time_;
+}
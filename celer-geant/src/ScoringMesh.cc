@@ -0,0 +1,329 @@
+//------------------------------- -*- C++ -*- -------------------------------//
+// Copyright Celeritas contributors: see top-level COPYRIGHT file for details
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+//---------------------------------------------------------------------------//
+//! \file celer-geant/src/ScoringMesh.cc
+//---------------------------------------------------------------------------//
+#include "ScoringMesh.hh"
+
+#include <algorithm>
+#include <corecel/io/Logger.hh>
+
+#include "JsonReader.hh"
+
+namespace
+{
+//---------------------------------------------------------------------------//
+/*!
+ * Construct a uniform axis.
+ */
+ScoringMesh::Axis make_axis(size_t num_bins, double min, double max)
+{
+    CELER_VALIDATE(num_bins > 0 && max > min, << "invalid scoring mesh axis");
+    ScoringMesh::Axis result;
+    result.num_bins = num_bins;
+    result.min = min;
+    result.max = max;
+    result.inv_width = result.num_bins / (result.max - result.min);
+    auto const b = ScoringMesh::block_size();
+    result.num_blocks = (result.num_bins + b - 1) / b;
+    return result;
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Call a function with the index of every axis edge in [lo, hi].
+ */
+template<class F>
+void for_each_edge(ScoringMesh::Axis const& axis, double lo, double hi, F&& f)
+{
+    lo = std::max(lo, axis.min);
+    hi = std::min(hi, axis.max);
+    if (!(lo <= hi))
+    {
+        return;
+    }
+    auto const first = std::ceil((lo - axis.min) * axis.inv_width);
+    auto const last = std::min(std::floor((hi - axis.min) * axis.inv_width),
+                               static_cast<double>(axis.num_bins));
+    for (auto k = std::max(first, 0.0); k <= last; ++k)
+    {
+        f(axis.min + k / axis.inv_width);
+    }
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Add the chord parameter of a crossing if it is strictly inside the chord.
+ */
+void add_crossing(double t, std::vector<double>* result)
+{
+    if (t > 0 && t < 1)
+    {
+        result->push_back(t);
+    }
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Add the crossings of a coordinate that varies linearly along the chord.
+ */
+void add_linear_crossings(ScoringMesh::Axis const& axis,
+                          double x0,
+                          double x1,
+                          std::vector<double>* result)
+{
+    if (x0 == x1)
+    {
+        return;
+    }
+    double const inv_dx = 1 / (x1 - x0);
+    for_each_edge(axis, std::min(x0, x1), std::max(x0, x1), [&](double e) {
+        add_crossing((e - x0) * inv_dx, result);
+    });
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Add the crossings of cylinders around the z axis.
+ *
+ * The squared radius along the chord is the quadratic
+ * \f$ r^2(t) = a t^2 + 2 b t + c \f$ , so each cylinder is crossed at most
+ * twice, and only cylinders between the minimum and maximum radius of the
+ * chord are tested.
+ */
+void add_radial_crossings(ScoringMesh::Axis const& axis,
+                          ScoringMesh::Real3 const& pre,
+                          ScoringMesh::Real3 const& post,
+                          std::vector<double>* result)
+{
+    double const dx = post[0] - pre[0];
+    double const dy = post[1] - pre[1];
+    double const a = dx * dx + dy * dy;
+    if (a == 0)
+    {
+        return;
+    }
+    double const b = pre[0] * dx + pre[1] * dy;
+    double const c = pre[0] * pre[0] + pre[1] * pre[1];
+    auto r2 = [&](double t) { return std::max((a * t + 2 * b) * t + c, 0.0); };
+    double const r_lo = std::sqrt(r2(std::clamp(-b / a, 0.0, 1.0)));
+    double const r_hi = std::sqrt(std::max(r2(0), r2(1)));
+    for_each_edge(axis, r_lo, r_hi, [&](double e) {
+        double const disc = b * b - a * (c - e * e);
+        if (e <= 0 || disc < 0)
+        {
+            return;
+        }
+        double const sq = std::sqrt(disc);
+        add_crossing((-b - sq) / a, result);
+        add_crossing((-b + sq) / a, result);
+    });
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Add the crossings of half-planes bounded by the z axis [deg].
+ *
+ * A chord that does not meet the z axis sweeps the shorter arc between the
+ * azimuths of its endpoints, so only the edges on that arc (and their images
+ * one turn away) are tested.
+ */
+void add_azimuthal_crossings(ScoringMesh::Axis const& axis,
+                             ScoringMesh::Real3 const& pre,
+                             ScoringMesh::Real3 const& post,
+                             std::vector<double>* result)
+{
+    constexpr double deg_per_rad = 57.295779513082321;
+    double const phi0 = std::atan2(pre[1], pre[0]) * deg_per_rad;
+    double delta = std::atan2(post[1], post[0]) * deg_per_rad - phi0;
+    if (delta > 180)
+    {
+        delta -= 360;
+    }
+    else if (delta < -180)
+    {
+        delta += 360;
+    }
+    if (delta == 0)
+    {
+        return;
+    }
+
+    double const dx = post[0] - pre[0];
+    double const dy = post[1] - pre[1];
+    double const lo = std::min(phi0, phi0 + delta);
+    double const hi = std::max(phi0, phi0 + delta);
+    for (double turn : {-360.0, 0.0, 360.0})
+    {
+        for_each_edge(axis, lo - turn, hi - turn, [&](double e) {
+            double const phi = (e + turn) / deg_per_rad;
+            double const sin_phi = std::sin(phi);
+            double const cos_phi = std::cos(phi);
+            double const denom = cos_phi * dy - sin_phi * dx;
+            if (denom != 0)
+            {
+                add_crossing((sin_phi * pre[0] - cos_phi * pre[1]) / denom,
+                             result);
+            }
+        });
+    }
+}
+
+//---------------------------------------------------------------------------//
+}  // namespace
+
+//---------------------------------------------------------------------------//
+/*!
+ * Meshes declared in the JSON input.
+ */
+auto ScoringMesh::FromJson() -> VecMesh
+{
+    VecMesh result;
+    auto const& json = JsonReader::Instance();
+    if (!json.contains("scoring_meshes"))
+    {
+        return result;
+    }
+    for (auto const& [name, input] : json.at("scoring_meshes").items())
+    {
+        result.emplace_back(name, input);
+    }
+    return result;
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Construct from a JSON mesh definition.
+ */
+ScoringMesh::ScoringMesh(std::string name, nlohmann::json const& input)
+    : name_(std::move(name))
+{
+    JsonReader::Validate(input, "type");
+    auto const type = input.at("type").get<std::string>();
+    char const* axis_names[3];
+    if (type == "cartesian")
+    {
+        geometry_ = Geometry::cartesian;
+        axis_names[0] = "x";
+        axis_names[1] = "y";
+        axis_names[2] = "z";
+    }
+    else if (type == "cylindrical")
+    {
+        geometry_ = Geometry::cylindrical;
+        axis_names[0] = "r";
+        axis_names[1] = "phi";
+        axis_names[2] = "z";
+    }
+    else
+    {
+        CELER_VALIDATE(false,
+                       << "unknown scoring mesh type '" << type
+                       << "' (expected \"cartesian\" or \"cylindrical\")");
+    }
+
+    for (size_t i = 0; i < 3; ++i)
+    {
+        if (geometry_ == Geometry::cylindrical && i == 1
+            && !input.contains("phi"))
+        {
+            // Full azimuth in a single bin
+            axes_[i] = make_axis(1, 0, 360);
+            continue;
+        }
+        JsonReader::ValidateHistogram(input, axis_names[i]);
+        auto const& axis = input.at(axis_names[i]);
+        CELER_VALIDATE(!axis.contains("edges"),
+                       << "scoring mesh axes must be uniform");
+        axes_[i] = make_axis(axis.at("num_bins").get<size_t>(),
+                             axis.at("min").get<double>(),
+                             axis.at("max").get<double>());
+    }
+    CELER_VALIDATE(geometry_ != Geometry::cylindrical || axes_[0].min >= 0,
+                   << "scoring mesh '" << name_ << "' has a negative radius");
+    normalize_ = input.contains("normalize")
+                 && input.at("normalize").get<bool>();
+
+    auto const b = block_size();
+    storage_size_ = axes_[0].num_blocks * axes_[1].num_blocks
+                    * axes_[2].num_blocks * b * b * b;
+    CELER_LOG(info) << "Scoring mesh '" << name_ << "' has "
+                    << axes_[0].num_bins * axes_[1].num_bins
+                           * axes_[2].num_bins
+                    << " voxels";
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Score a step between two points [cm].
+ *
+ * The chord from \c pre to \c post is split at every voxel edge it crosses,
+ * and each piece receives its fraction of \c step_len , which can be longer
+ * than the chord for curved steps. The energy deposition goes to the voxel of
+ * the step midpoint.
+ */
+void ScoringMesh::Score(Real3 const& pre,
+                        Real3 const& post,
+                        double edep,
+                        double step_len,
+                        MeshTally* tally) const
+{
+    CELER_EXPECT(tally && tally->edep.size() == storage_size_);
+
+    auto point = [&](double t) {
+        return Real3{pre[0] + t * (post[0] - pre[0]),
+                     pre[1] + t * (post[1] - pre[1]),
+                     pre[2] + t * (post[2] - pre[2])};
+    };
+
+    auto const mid = this->Find(point(0.5));
+    if (mid != invalid())
+    {
+        tally->FillEdep(mid, edep);
+    }
+
+    // Reused by every step of the thread to avoid allocations
+    static thread_local std::vector<double> crossings;
+    crossings.assign({0.0, 1.0});
+    this->AddCrossings(pre, post, &crossings);
+    std::sort(crossings.begin(), crossings.end());
+
+    for (size_t i = 0; i + 1 < crossings.size(); ++i)
+    {
+        double const dt = crossings[i + 1] - crossings[i];
+        if (dt <= 0)
+        {
+            continue;
+        }
+        auto const idx
+            = this->Find(point((crossings[i] + crossings[i + 1]) / 2));
+        if (idx != invalid())
+        {
+            tally->FillTrackLength(idx, dt * step_len);
+        }
+    }
+}
+
+//---------------------------------------------------------------------------//
+// PRIVATE
+//---------------------------------------------------------------------------//
+/*!
+ * Add the chord parameters in (0, 1) at which a step crosses voxel edges.
+ */
+void ScoringMesh::AddCrossings(Real3 const& pre,
+                               Real3 const& post,
+                               std::vector<double>* result) const
+{
+    if (geometry_ == Geometry::cartesian)
+    {
+        for (size_t i = 0; i < 3; ++i)
+        {
+            add_linear_crossings(axes_[i], pre[i], post[i], result);
+        }
+        return;
+    }
+    add_radial_crossings(axes_[0], pre, post, result);
+    add_azimuthal_crossings(axes_[1], pre, post, result);
+    add_linear_crossings(axes_[2], pre[2], post[2], result);
+}
@@ -0,0 +1,261 @@
+//------------------------------- -*- C++ -*- -------------------------------//
+// Copyright Celeritas contributors: see top-level COPYRIGHT file for details
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+//---------------------------------------------------------------------------//
+//! \file celer-geant/src/ScoringMesh.hh
+//---------------------------------------------------------------------------//
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <corecel/Assert.hh>
+#include <nlohmann/json.hpp>
+
+#include "Histogram.hh"
+
+//---------------------------------------------------------------------------//
+/*!
+ * Energy deposition and track length accumulated in the voxels of a mesh.
+ *
+ * Both vectors are indexed by \c ScoringMesh::Find and are empty until the
+ * tally is allocated for a mesh. Voxels are \c HistogramBin s, filled per
+ * event and folded by \c EndEvent like the bins of sensitive detector
+ * histograms, so that their errors come from the event-to-event variance.
+ */
+struct MeshTally
+{
+    using VecBin = std::vector<HistogramBin>;
+
+    VecBin edep;  //!< [MeV]
+    VecBin track_length;  //!< [cm]
+    std::vector<size_t> pending;  //!< Voxels filled in the current event
+
+    //! Add energy deposition to a voxel in the current event
+    void FillEdep(size_t idx, double value)
+    {
+        this->Fill(idx, value, &edep);
+    }
+
+    //! Add track length to a voxel in the current event
+    void FillTrackLength(size_t idx, double value)
+    {
+        this->Fill(idx, value, &track_length);
+    }
+
+    //! Fold the voxels filled in the current event
+    void EndEvent()
+    {
+        for (auto i : pending)
+        {
+            edep[i].EndEvent();
+            track_length[i].EndEvent();
+        }
+        pending.clear();
+    }
+
+    //! Accumulate the tally of the same mesh from another thread
+    void Merge(MeshTally const& other)
+    {
+        CELER_EXPECT(other.pending.empty());
+        if (other.edep.empty())
+        {
+            return;
+        }
+        if (edep.empty())
+        {
+            *this = other;
+            return;
+        }
+        CELER_EXPECT(edep.size() == other.edep.size());
+        for (size_t i = 0; i < edep.size(); ++i)
+        {
+            edep[i] += other.edep[i];
+            track_length[i] += other.track_length[i];
+        }
+    }
+
+  private:
+    void Fill(size_t idx, double value, VecBin* bins)
+    {
+        auto& bin = (*bins)[idx];
+        if (!edep[idx].pending && !track_length[idx].pending)
+        {
+            pending.push_back(idx);
+        }
+        bin.pending = true;
+        bin.event_w += value;
+    }
+};
+
+//---------------------------------------------------------------------------//
+/*!
+ * Cartesian or cylindrical scoring mesh, independent of sensitive detectors.
+ *
+ * Meshes are declared in the \c "scoring_meshes" JSON block, with axes in cm
+ * (and degrees for the optional azimuthal axis, which defaults to a single
+ * bin):
+ * \code
+   "scoring_meshes": {
+       "dose": {"type": "cartesian",
+                "x": {"num_bins": 100, "min": -50, "max": 50},
+                "y": {"num_bins": 100, "min": -50, "max": 50},
+                "z": {"num_bins": 200, "min": 0, "max": 200}},
+       "barrel": {"type": "cylindrical",
+                  "r": {"num_bins": 50, "min": 0, "max": 150},
+                  "phi": {"num_bins": 36, "min": 0, "max": 360},
+                  "z": {"num_bins": 100, "min": -300, "max": 300}}
+   }
+   \endcode
+ *
+ * The track length of a step is split among the voxels crossed by its chord,
+ * each voxel receiving the fraction of the step length that lies inside it.
+ * The energy deposition is scored in the voxel that contains the step
+ * midpoint. Voxels are stored in blocks of 4 x 4 x 4, so that voxels which
+ * are neighbours along any axis usually share a cache line or page, as
+ * consecutive steps of a track do.
+ *
+ * With \c "normalize": true in a mesh definition, its tallies are divided by
+ * the number of events, as for sensitive detector histograms.
+ */
+class ScoringMesh
+{
+  public:
+    enum class Geometry
+    {
+        cartesian,
+        cylindrical
+    };
+
+    //! Uniform axis: x, y, z or r, phi, z
+    struct Axis
+    {
+        size_t num_bins{0};
+        double min{0};
+        double max{0};
+        double inv_width{0};
+        size_t num_blocks{0};
+    };
+
+    using Real3 = std::array<double, 3>;
+    using VecMesh = std::vector<ScoringMesh>;
+
+    //! Number of voxels along each edge of a storage block
+    static constexpr size_t block_size() { return 4; }
+
+    //! Index of a position outside the mesh
+    static constexpr size_t invalid() { return static_cast<size_t>(-1); }
+
+  public:
+    // Meshes declared in the JSON input
+    static VecMesh FromJson();
+
+    // Construct from a JSON mesh definition
+    ScoringMesh(std::string name, nlohmann::json const& input);
+
+    // Storage index of the voxel containing a position [cm]
+    inline size_t Find(Real3 const& pos) const;
+
+    // Storage index of the voxel with the given bins
+    inline size_t Index(size_t i, size_t j, size_t k) const;
+
+    // Score a step between two points [cm]
+    void Score(Real3 const& pre,
+               Real3 const& post,
+               double edep,
+               double step_len,
+               MeshTally* tally) const;
+
+    //! Allocate an empty tally
+    MeshTally MakeTally() const
+    {
+        MeshTally result;
+        result.edep.resize(storage_size_);
+        result.track_length.resize(storage_size_);
+        return result;
+    }
+
+    //! Mesh name
+    std::string const& name() const { return name_; }
+
+    //! Whether tallies are divided by the number of events
+    bool normalize() const { return normalize_; }
+
+    //! Mesh geometry
+    Geometry geometry() const { return geometry_; }
+
+    //! Axis along dimension \c i
+    Axis const& axis(size_t i) const { return axes_[i]; }
+
+  private:
+    std::string name_;
+    Geometry geometry_{Geometry::cartesian};
+    std::array<Axis, 3> axes_;
+    size_t storage_size_{0};
+    bool normalize_{false};
+
+    // Bin along an axis, or invalid
+    static inline size_t FindBin(Axis const& axis, double x);
+
+    // Add the chord parameters in (0, 1) at which a step crosses voxel edges
+    void AddCrossings(Real3 const& pre,
+                      Real3 const& post,
+                      std::vector<double>* result) const;
+};
+
+//---------------------------------------------------------------------------//
+// INLINE DEFINITIONS
+//---------------------------------------------------------------------------//
+/*!
+ * Storage index of the voxel containing a position [cm].
+ */
+size_t ScoringMesh::Find(Real3 const& pos) const
+{
+    Real3 coords = pos;
+    if (geometry_ == Geometry::cylindrical)
+    {
+        coords[0] = std::hypot(pos[0], pos[1]);
+        constexpr double deg_per_rad = 57.295779513082321;
+        double const phi = std::atan2(pos[1], pos[0]) * deg_per_rad;
+        coords[1] = phi < 0 ? phi + 360 : phi;
+    }
+
+    size_t bins[3];
+    for (size_t i = 0; i < 3; ++i)
+    {
+        bins[i] = FindBin(axes_[i], coords[i]);
+        if (bins[i] == invalid())
+        {
+            return invalid();
+        }
+    }
+    return this->Index(bins[0], bins[1], bins[2]);
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Storage index of the voxel with the given bins.
+ */
+size_t ScoringMesh::Index(size_t i, size_t j, size_t k) const
+{
+    constexpr size_t b = block_size();
+    size_t const block = ((k / b) * axes_[1].num_blocks + j / b)
+                             * axes_[0].num_blocks
+                         + i / b;
+    return block * b * b * b + ((k % b) * b + j % b) * b + i % b;
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Bin along an axis, or invalid.
+ */
+size_t ScoringMesh::FindBin(Axis const& axis, double x)
+{
+    if (!(x >= axis.min && x < axis.max))
+    {
+        return invalid();
+    }
+    auto const bin = static_cast<size_t>((x - axis.min) * axis.inv_width);
+    return bin < axis.num_bins ? bin : axis.num_bins - 1;
+}
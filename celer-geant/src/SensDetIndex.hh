@@ -0,0 +1,181 @@
+//------------------------------- -*- C++ -*- -------------------------------//
+// Copyright Celeritas contributors: see top-level COPYRIGHT file for details
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+//---------------------------------------------------------------------------//
+//! \file celer-geant/src/SensDetIndex.hh
+//---------------------------------------------------------------------------//
+#pragma once
+
+#include <algorithm>
+#include <iterator>
+#include <tuple>
+#include <vector>
+#include <corecel/Assert.hh>
+
+//---------------------------------------------------------------------------//
+/*!
+ * Helper struct for indexing physical volumes to an object.
+ * (e.g. std::map<SensDetId, SensDetData> map)
+ */
+struct SensDetId
+{
+    size_t physvol_id;
+    size_t copy_number;
+};
+
+//---------------------------------------------------------------------------//
+//! Overload \c operator< for \c map.find(sensdetid) compatibility.
+inline bool operator<(SensDetId const& lhs, SensDetId const& rhs)
+{
+    return std::make_tuple(lhs.physvol_id, lhs.copy_number)
+           < std::make_tuple(rhs.physvol_id, rhs.copy_number);
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Dense lookup table from physical volume instance ID and copy number to an
+ * index.
+ *
+ * Geant4 assigns physical volume instance IDs sequentially, so the table
+ * stores one copy-number range per instance ID, and each range points to a
+ * contiguous block of slots. A lookup is therefore two array accesses with no
+ * branching on the key beyond bounds checks:
+ * \code
+   SensDetIndex index(std::move(entries));
+   auto idx = index.Find(pv_id, copy_num);
+   \endcode
+ *
+ * Copy numbers that fall inside a range but were never inserted (e.g. sparse
+ * replica copy numbers) map to \c SensDetIndex::invalid() . Inserted copy
+ * numbers must be nonnegative: a negative \c G4VPhysicalVolume::GetCopyNo
+ * converted to \c CopyNumber would size the range to the whole address space.
+ * A negative copy number passed to \c Find wraps to a huge value and maps to
+ * \c invalid() .
+ */
+class SensDetIndex
+{
+  public:
+    //!@{
+    //! \name Type aliases
+    using PhysVolId = size_t;
+    using CopyNumber = size_t;
+    using size_type = size_t;
+    //!@}
+
+    //! Key-value pair used during construction
+    struct Entry
+    {
+        SensDetId id;
+        size_type index;
+    };
+
+    //! Sentinel returned for unmapped volumes
+    static constexpr size_type invalid() { return static_cast<size_type>(-1); }
+
+    //! Maximum ratio of table slots to inserted entries of a volume
+    static constexpr size_type max_sparsity() { return 1024; }
+
+    //! Construct empty
+    SensDetIndex() = default;
+
+    // Construct from a list of unique keys and their indices
+    inline explicit SensDetIndex(std::vector<Entry> entries);
+
+    // Find the index for a given physical volume ID and copy number
+    inline size_type Find(PhysVolId pv_id, CopyNumber copy_num) const;
+
+    //! Number of physical volume instance IDs covered by the table
+    size_type NumPhysVols() const { return ranges_.size(); }
+
+    //! Whether the table is empty
+    bool empty() const { return slots_.empty(); }
+
+  private:
+    // Copy-number range of a single physical volume
+    struct Range
+    {
+        size_type offset{0};
+        CopyNumber first_copy{0};
+        size_type size{0};
+    };
+
+    std::vector<Range> ranges_;
+    std::vector<size_type> slots_;
+};
+
+//---------------------------------------------------------------------------//
+// INLINE DEFINITIONS
+//---------------------------------------------------------------------------//
+/*!
+ * Construct from a list of unique keys and their indices.
+ */
+SensDetIndex::SensDetIndex(std::vector<Entry> entries)
+{
+    if (entries.empty())
+    {
+        return;
+    }
+
+    std::sort(entries.begin(),
+              entries.end(),
+              [](auto const& a, auto const& b) { return a.id < b.id; });
+
+    ranges_.resize(entries.back().id.physvol_id + 1);
+    for (auto iter = entries.begin(); iter != entries.end();)
+    {
+        // Find all entries of this physical volume
+        auto const pid = iter->id.physvol_id;
+        auto const last = std::find_if(iter, entries.end(), [pid](auto& e) {
+            return e.id.physvol_id != pid;
+        });
+
+        auto& range = ranges_[pid];
+        range.offset = slots_.size();
+        range.first_copy = iter->id.copy_number;
+        auto const span = std::prev(last)->id.copy_number - range.first_copy;
+        auto const num_copies
+            = static_cast<size_type>(std::distance(iter, last));
+        CELER_VALIDATE(span < num_copies * max_sparsity(),
+                       << "copy numbers " << range.first_copy << " to "
+                       << std::prev(last)->id.copy_number
+                       << " of physical volume " << pid
+                       << " are too sparse to index");
+        range.size = span + 1;
+        slots_.resize(range.offset + range.size, invalid());
+
+        for (; iter != last; ++iter)
+        {
+            auto& slot = slots_[range.offset + iter->id.copy_number
+                                - range.first_copy];
+            CELER_VALIDATE(slot == invalid(),
+                           << "duplicate sensitive detector entry for "
+                              "physical volume "
+                           << pid << " with copy number "
+                           << iter->id.copy_number);
+            slot = iter->index;
+        }
+    }
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Find the index for a given physical volume ID and copy number.
+ *
+ * Copy numbers below the first one in the range wrap around and fail the size
+ * check, so a single comparison covers both bounds.
+ */
+auto SensDetIndex::Find(PhysVolId pv_id, CopyNumber copy_num) const
+    -> size_type
+{
+    if (pv_id >= ranges_.size())
+    {
+        return invalid();
+    }
+    auto const& range = ranges_[pv_id];
+    auto const slot = copy_num - range.first_copy;
+    if (slot >= range.size)
+    {
+        return invalid();
+    }
+    return slots_[range.offset + slot];
+}
@@ -9,11 +9,15 @@
 #include <string>
 #include <G4VSensitiveDetector.hh>
 
+#include "ScoringFilter.hh"
+
 //---------------------------------------------------------------------------//
 /*!
  * Sensitive detector class.
  *
  * This is currently the *only* interface between Geant4 and Celeritas.
+ * Steps are scored only if they pass the \c ScoringFilter configured for
+ * this SD name.
  */
 class SensitiveDetector : public G4VSensitiveDetector
 {
@@ -25,9 +29,6 @@ class SensitiveDetector : public G4VSensitiveDetector
     G4bool ProcessHits(G4Step* step, G4TouchableHistory*) final;
 
   private:
-    using PDG = int;
-    std::vector<PDG> valid_pdgs_{11, -11, 22};
-
-    // Verify if PDG is in the list of offloaded particles
-    bool is_pdg_valid(PDG id) const;
+    // Compiled step filter for this SD
+    ScoringFilter filter_;
 };
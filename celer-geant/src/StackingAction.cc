@@ -6,41 +6,59 @@
 //---------------------------------------------------------------------------//
 #include "StackingAction.hh"
 
-#include <algorithm>
 #include <G4ClassificationOfNewTrack.hh>
 #include <G4Track.hh>
 #include <corecel/Assert.hh>
 
-#include "JsonReader.hh"
+#include "Config.hh"
+#include "Profiler.hh"
+
 //---------------------------------------------------------------------------//
 /*!
- * Construct with list of valid PDGs from JSON.
+ * Construct with list of offloaded PDGs.
  */
-StackingAction::StackingAction() : G4UserStackingAction()
+StackingAction::StackingAction()
+    : G4UserStackingAction()
+    , valid_pdgs_(Config::Instance().offload_pdgs)
+    , policy_enabled_(Config::Instance().offload_policy.enabled())
 {
-    JsonReader::Validate(JsonReader::Instance(), "celeritas");
-    auto const& json = JsonReader::Instance().at("celeritas");
-    if (json.contains("offload_particles"))
-    {
-        valid_pdgs_ = json.at("offload_particles").get<std::vector<PDG>>();
-    }
 }
 
 //---------------------------------------------------------------------------//
 /*!
  * Assign \c fKill to all non-offloaded particles.
+ *
+ * With an offload policy, whether a track is offloaded is only decided by
+ * \c HybridTrackingManager , which then counts it for profiling.
  */
 G4ClassificationOfNewTrack
 StackingAction::ClassifyNewTrack(G4Track* const track)
 {
-    auto is_valid = [this](PDG pdg) -> bool {
-        return std::any_of(this->valid_pdgs_.begin(),
-                           this->valid_pdgs_.end(),
-                           [&pdg](PDG this_pdg) { return this_pdg == pdg; });
-    };
-
     auto* pd = track->GetParticleDefinition();
     CELER_ASSERT(pd);
 
-    return is_valid(pd->GetPDGEncoding()) ? fUrgent : fKill;
+    bool const offload = valid_pdgs_.contains(pd->GetPDGEncoding());
+    if constexpr (Profiler::enabled())
+    {
+        if (!offload || !policy_enabled_)
+        {
+            Profiler::Instance().CountTrack(offload);
+        }
+    }
+    return offload ? fUrgent : fKill;
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Mark the start of the Celeritas flush for profiling.
+ *
+ * Geant4 starts a new stage whenever its urgent stack is empty, after which
+ * Celeritas transports the offloaded tracks buffered during the event.
+ */
+void StackingAction::NewStage()
+{
+    if constexpr (Profiler::enabled())
+    {
+        Profiler::Instance().NewStage();
+    }
 }
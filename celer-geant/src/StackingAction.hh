@@ -6,9 +6,10 @@
 //---------------------------------------------------------------------------//
 #pragma once
 
-#include <vector>
 #include <G4UserStackingAction.hh>
 
+#include "PdgSet.hh"
+
 //---------------------------------------------------------------------------//
 /*!
  * Classify any particle that should not be offloaded as \c fKill .
@@ -24,7 +25,10 @@ class StackingAction : public G4UserStackingAction
     // Kill non-offloaded tracks
     G4ClassificationOfNewTrack ClassifyNewTrack(G4Track* const track);
 
+    // Mark the start of the Celeritas flush for profiling
+    void NewStage() final;
+
   private:
-    using PDG = int;
-    std::vector<PDG> valid_pdgs_{11, -11, 22};
+    PdgSet valid_pdgs_;
+    bool policy_enabled_;  //!< Offloading is counted by the policy
 };
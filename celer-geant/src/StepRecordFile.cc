@@ -0,0 +1,295 @@
+//------------------------------- -*- C++ -*- -------------------------------//
+// Copyright Celeritas contributors: see top-level COPYRIGHT file for details
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+//---------------------------------------------------------------------------//
+//! \file celer-geant/src/StepRecordFile.cc
+//---------------------------------------------------------------------------//
+#include "StepRecordFile.hh"
+
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <sstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <corecel/io/Logger.hh>
+
+namespace
+{
+//---------------------------------------------------------------------------//
+//! File signature and format version.
+char const step_record_magic[8] = {'C', 'G', 'S', 'T', 'E', 'P', 'S', '\0'};
+constexpr std::uint32_t step_record_version = 1;
+
+//---------------------------------------------------------------------------//
+//! Number of pages mapped at once by a writer.
+constexpr std::size_t chunk_pages = 256;
+
+//---------------------------------------------------------------------------//
+/*!
+ * Description of the last system error.
+ */
+std::string error_string()
+{
+    return std::strerror(errno);
+}
+
+//---------------------------------------------------------------------------//
+}  // namespace
+
+//---------------------------------------------------------------------------//
+/*!
+ * Create the file and write the SD names.
+ *
+ * A chunk holds a whole number of pages and of records, so that every chunk
+ * starts on a page boundary and no record spans two chunks.
+ */
+StepRecordWriter::StepRecordWriter(std::string filename,
+                                   std::vector<std::string> const& sd_names)
+    : filename_(std::move(filename))
+{
+    fd_ = ::open(filename_.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    CELER_VALIDATE(fd_ >= 0,
+                   << "cannot create step record file \"" << filename_
+                   << "\": " << error_string());
+
+    std::string names;
+    for (auto const& name : sd_names)
+    {
+        names += name;
+        names += '\n';
+    }
+    names_size_ = names.size();
+
+    auto const page_size = static_cast<std::uint64_t>(::sysconf(_SC_PAGESIZE));
+    auto const header_size = sizeof(StepRecordHeader) + names_size_;
+    data_offset_ = (header_size + page_size - 1) / page_size * page_size;
+    chunk_records_ = page_size * chunk_pages;
+    pos_ = chunk_records_;
+
+    CELER_VALIDATE(::pwrite(fd_,
+                            names.data(),
+                            names.size(),
+                            sizeof(StepRecordHeader))
+                       == static_cast<ssize_t>(names.size()),
+                   << "cannot write step record file \"" << filename_
+                   << "\": " << error_string());
+    CELER_LOG_LOCAL(debug) << "Writing step records to \"" << filename_
+                           << "\"";
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Close the file if needed.
+ */
+StepRecordWriter::~StepRecordWriter()
+{
+    try
+    {
+        this->Close();
+    }
+    catch (std::exception const& e)
+    {
+        CELER_LOG_LOCAL(error) << e.what();
+    }
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Complete the header and truncate the file to its records.
+ */
+void StepRecordWriter::Close()
+{
+    if (fd_ < 0)
+    {
+        return;
+    }
+    this->Unmap();
+
+    StepRecordHeader header{};
+    std::memcpy(header.magic, step_record_magic, sizeof(header.magic));
+    header.version = step_record_version;
+    header.record_size = sizeof(PackedStep);
+    header.num_records = num_records_;
+    header.num_events = num_events_;
+    header.data_offset = data_offset_;
+    header.names_size = names_size_;
+    header.length_scale = PackedStep::length_scale();
+    header.dir_scale = PackedStep::dir_scale();
+
+    auto const size = data_offset_ + num_records_ * sizeof(PackedStep);
+    bool const ok = ::pwrite(fd_, &header, sizeof(header), 0)
+                        == static_cast<ssize_t>(sizeof(header))
+                    && ::ftruncate(fd_, static_cast<off_t>(size)) == 0;
+    ::close(fd_);
+    fd_ = -1;
+    CELER_VALIDATE(ok,
+                   << "cannot write step record file \"" << filename_
+                   << "\": " << error_string());
+    CELER_LOG_LOCAL(info) << "Wrote " << num_records_ << " step records of "
+                          << num_events_ << " events to \"" << filename_
+                          << "\"";
+    if (num_clamped_ > 0)
+    {
+        CELER_LOG_LOCAL(warning)
+            << num_clamped_ << " step records in \"" << filename_
+            << "\" have positions beyond +-" << PackedStep::max_position()
+            << " cm, which were clamped";
+    }
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Map the next chunk of the file.
+ */
+void StepRecordWriter::Remap()
+{
+    this->Unmap();
+
+    auto const chunk_size = chunk_records_ * sizeof(PackedStep);
+    auto const offset = data_offset_ + num_records_ * sizeof(PackedStep);
+    CELER_VALIDATE(
+        ::ftruncate(fd_, static_cast<off_t>(offset + chunk_size)) == 0,
+        << "cannot extend step record file \"" << filename_
+        << "\": " << error_string());
+    void* data = ::mmap(nullptr,
+                        chunk_size,
+                        PROT_READ | PROT_WRITE,
+                        MAP_SHARED,
+                        fd_,
+                        static_cast<off_t>(offset));
+    CELER_VALIDATE(data != MAP_FAILED,
+                   << "cannot map step record file \"" << filename_
+                   << "\": " << error_string());
+    chunk_ = static_cast<PackedStep*>(data);
+    pos_ = 0;
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Unmap the current chunk.
+ *
+ * The kernel writes the dirty pages back asynchronously.
+ */
+void StepRecordWriter::Unmap()
+{
+    if (!chunk_)
+    {
+        return;
+    }
+    ::munmap(chunk_, chunk_records_ * sizeof(PackedStep));
+    chunk_ = nullptr;
+    num_records_ += pos_;
+    pos_ = chunk_records_;
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Per-thread step record files of a \c "step_records" filename.
+ *
+ * For \c "steps.bin" these are \c "steps-[thread].steps" , sorted by name.
+ */
+std::vector<std::string>
+StepRecordReader::FindFiles(std::string const& filename)
+{
+    namespace fs = std::filesystem;
+
+    fs::path const stem = filename.substr(0, filename.find_last_of("."));
+    auto const dir = stem.has_parent_path() ? stem.parent_path()
+                                            : fs::path(".");
+    auto const prefix = stem.filename().string() + "-";
+    std::string const ext = ".steps";
+
+    std::vector<std::string> result;
+    if (!fs::is_directory(dir))
+    {
+        return result;
+    }
+    for (auto const& entry : fs::directory_iterator(dir))
+    {
+        auto const name = entry.path().filename().string();
+        if (name.size() <= prefix.size() + ext.size()
+            || name.compare(0, prefix.size(), prefix) != 0
+            || entry.path().extension() != ext)
+        {
+            continue;
+        }
+        auto const suffix = name.substr(
+            prefix.size(), name.size() - prefix.size() - ext.size());
+        if (std::all_of(suffix.begin(), suffix.end(), [](unsigned char c) {
+                return std::isdigit(c);
+            }))
+        {
+            result.push_back(entry.path().string());
+        }
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Map a file and validate its header.
+ */
+StepRecordReader::StepRecordReader(std::string const& filename)
+{
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    CELER_VALIDATE(fd >= 0,
+                   << "cannot open step record file \"" << filename
+                   << "\": " << error_string());
+    struct stat st;
+    bool const ok = ::fstat(fd, &st) == 0;
+    size_ = ok ? static_cast<std::size_t>(st.st_size) : 0;
+    if (size_ >= sizeof(StepRecordHeader))
+    {
+        data_ = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    ::close(fd);
+    CELER_VALIDATE(data_ && data_ != MAP_FAILED,
+                   << "cannot map step record file \"" << filename << "\"");
+
+    StepRecordHeader header;
+    std::memcpy(&header, data_, sizeof(header));
+    CELER_VALIDATE(
+        std::memcmp(header.magic, step_record_magic, sizeof(header.magic))
+                == 0
+            && header.version == step_record_version
+            && header.record_size == sizeof(PackedStep)
+            && header.length_scale == PackedStep::length_scale()
+            && header.dir_scale == PackedStep::dir_scale(),
+        << "\"" << filename
+        << "\" is not a compatible step record file, or its run was "
+           "interrupted");
+    CELER_VALIDATE(header.data_offset + header.num_records * sizeof(PackedStep)
+                       <= size_,
+                   << "step record file \"" << filename << "\" is truncated");
+
+    auto const* bytes = static_cast<char const*>(data_);
+    std::istringstream names(
+        std::string(bytes + sizeof(header), header.names_size));
+    for (std::string name; std::getline(names, name);)
+    {
+        sd_names_.push_back(std::move(name));
+    }
+    records_ = reinterpret_cast<PackedStep const*>(bytes + header.data_offset);
+    num_records_ = header.num_records;
+    num_events_ = header.num_events;
+
+    // Records are read once, in order
+    ::madvise(data_, size_, MADV_SEQUENTIAL);
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Unmap the file.
+ */
+StepRecordReader::~StepRecordReader()
+{
+    if (data_ && data_ != MAP_FAILED)
+    {
+        ::munmap(data_, size_);
+    }
+}
@@ -0,0 +1,283 @@
+//------------------------------- -*- C++ -*- -------------------------------//
+// Copyright Celeritas contributors: see top-level COPYRIGHT file for details
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+//---------------------------------------------------------------------------//
+//! \file celer-geant/src/StepRecordFile.hh
+//---------------------------------------------------------------------------//
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <corecel/Assert.hh>
+
+#include "Observable.hh"
+
+//---------------------------------------------------------------------------//
+/*!
+ * Fixed-width, quantized record of a scored step.
+ *
+ * Positions are stored as integers in units of \c length_scale (1 um,
+ * i.e. a range of about +-2.1 km given by \c max_position ), directions as
+ * integers in units of \c dir_scale , and energies and times as single
+ * precision floats. Positions outside the range are clamped to it.
+ */
+struct PackedStep
+{
+    std::uint32_t event;  //!< Index of the event in its file
+    std::uint32_t sd;  //!< Index of the SD in RootDataStore::SensDets
+    std::int32_t pdg;
+    float edep;  //!< [MeV]
+    float step_len;  //!< [cm]
+    float energy[2];  //!< Pre/post-step kinetic energy [MeV]
+    float time[2];  //!< Pre/post-step global time [ns]
+    std::int32_t pos[2][3];  //!< Pre/post-step position [length_scale]
+    std::int16_t dir[2][3];  //!< Pre/post-step direction [dir_scale]
+    std::uint32_t has_dir;
+
+    //! Quantum of positions [cm]
+    static constexpr double length_scale() { return 1e-4; }
+
+    //! Largest position magnitude that is stored exactly [cm]
+    static constexpr double max_position()
+    {
+        return 2147483647. * length_scale();
+    }
+
+    //! Quantum of direction components
+    static constexpr double dir_scale() { return 1. / 32767; }
+};
+
+static_assert(sizeof(PackedStep) == 76, "unexpected step record padding");
+
+//---------------------------------------------------------------------------//
+/*!
+ * Header at the start of every step record file.
+ *
+ * It is followed by the newline-separated SD names, and records start at
+ * the page-aligned \c data_offset .
+ */
+struct StepRecordHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t record_size;
+    std::uint64_t num_records;
+    std::uint64_t num_events;
+    std::uint64_t data_offset;  //!< Byte offset of the first record
+    std::uint64_t names_size;  //!< Bytes of SD names after the header
+    double length_scale;  //!< [cm]
+    double dir_scale;
+};
+
+//---------------------------------------------------------------------------//
+/*!
+ * Memory-mapped step record output of a worker thread.
+ *
+ * Records are copied into a shared file mapping, which grows by fixed
+ * chunks, so that writing a step is a single store with no system call or
+ * buffering on the tracking thread; the kernel writes dirty pages back in
+ * the background. The header is completed by \c Close .
+ *
+ * Records of an event are contiguous, and their \c event index is the
+ * number of \c EndEvent calls before them.
+ */
+class StepRecordWriter
+{
+  public:
+    // Create the file and write the SD names
+    StepRecordWriter(std::string filename,
+                     std::vector<std::string> const& sd_names);
+
+    // Close the file if needed
+    ~StepRecordWriter();
+
+    //!@{
+    //! Prevent copying and moving
+    StepRecordWriter(StepRecordWriter const&) = delete;
+    StepRecordWriter& operator=(StepRecordWriter const&) = delete;
+    //!@}
+
+    // Append a scored step
+    inline void Write(std::size_t sd, int pdg, StepRecord const& rec);
+
+    //! Start the next event
+    void EndEvent() { ++num_events_; }
+
+    // Complete the header and truncate the file to its records
+    void Close();
+
+  private:
+    std::string filename_;
+    int fd_{-1};
+    std::uint64_t data_offset_{0};
+    std::uint64_t names_size_{0};
+    std::size_t chunk_records_{0};
+    PackedStep* chunk_{nullptr};
+    std::size_t pos_{0};  //!< Records written in the current chunk
+    std::uint64_t num_records_{0};  //!< Records of previous chunks
+    std::uint32_t num_events_{0};
+    std::uint64_t num_clamped_{0};  //!< Records with clamped positions
+
+    // Map the next chunk of the file
+    void Remap();
+
+    // Unmap the current chunk
+    void Unmap();
+};
+
+//---------------------------------------------------------------------------//
+/*!
+ * Read-only memory mapping of a step record file.
+ */
+class StepRecordReader
+{
+  public:
+    // Per-thread step record files of a "step_records" filename
+    static std::vector<std::string> FindFiles(std::string const& filename);
+
+    // Map a file and validate its header
+    explicit StepRecordReader(std::string const& filename);
+
+    // Unmap the file
+    ~StepRecordReader();
+
+    //!@{
+    //! Prevent copying and moving
+    StepRecordReader(StepRecordReader const&) = delete;
+    StepRecordReader& operator=(StepRecordReader const&) = delete;
+    //!@}
+
+    //! First record
+    PackedStep const* begin() const { return records_; }
+
+    //! Past the last record
+    PackedStep const* end() const { return records_ + num_records_; }
+
+    //! Number of records
+    std::size_t size() const { return num_records_; }
+
+    //! Number of events written by the thread, including empty ones
+    std::size_t num_events() const { return num_events_; }
+
+    //! SD names, indexed by \c PackedStep::sd
+    std::vector<std::string> const& sd_names() const { return sd_names_; }
+
+  private:
+    void* data_{nullptr};
+    std::size_t size_{0};
+    PackedStep const* records_{nullptr};
+    std::size_t num_records_{0};
+    std::size_t num_events_{0};
+    std::vector<std::string> sd_names_;
+};
+
+//---------------------------------------------------------------------------//
+// FREE FUNCTIONS
+//---------------------------------------------------------------------------//
+/*!
+ * Quantize a step record.
+ */
+inline PackedStep
+pack_step(std::uint32_t event, std::size_t sd, int pdg, StepRecord const& rec)
+{
+    auto quantize_pos = [](double x) {
+        constexpr double limit = 2147483647.;
+        double const q = std::round(x / PackedStep::length_scale());
+        return static_cast<std::int32_t>(std::clamp(q, -limit, limit));
+    };
+    auto quantize_dir = [](double x) {
+        return static_cast<std::int16_t>(
+            std::lround(std::clamp(x, -1., 1.) / PackedStep::dir_scale()));
+    };
+
+    PackedStep result;
+    result.event = event;
+    result.sd = static_cast<std::uint32_t>(sd);
+    result.pdg = pdg;
+    result.edep = static_cast<float>(rec.edep);
+    result.step_len = static_cast<float>(rec.step_len);
+    StepRecord::Point const* points[] = {&rec.pre, &rec.post};
+    for (int p = 0; p < 2; ++p)
+    {
+        result.energy[p] = static_cast<float>(points[p]->energy);
+        result.time[p] = static_cast<float>(points[p]->time);
+        for (int i = 0; i < 3; ++i)
+        {
+            result.pos[p][i] = quantize_pos(points[p]->pos[i]);
+            result.dir[p][i] = quantize_dir(points[p]->dir[i]);
+        }
+    }
+    result.has_dir = rec.has_dir;
+    return result;
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Whether the positions of a step record fit in a \c PackedStep .
+ */
+inline bool is_packable(StepRecord const& rec)
+{
+    constexpr double limit = PackedStep::max_position();
+    for (auto const* point : {&rec.pre, &rec.post})
+    {
+        for (double x : point->pos)
+        {
+            if (!(std::fabs(x) <= limit))
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Restore a step record from its quantized form.
+ */
+inline StepRecord unpack_step(PackedStep const& packed)
+{
+    StepRecord result;
+    StepRecord::Point* points[] = {&result.pre, &result.post};
+    for (int p = 0; p < 2; ++p)
+    {
+        points[p]->energy = packed.energy[p];
+        points[p]->time = packed.time[p];
+        for (int i = 0; i < 3; ++i)
+        {
+            points[p]->pos[i] = packed.pos[p][i] * PackedStep::length_scale();
+            points[p]->dir[i] = packed.dir[p][i] * PackedStep::dir_scale();
+        }
+    }
+    result.edep = packed.edep;
+    result.step_len = packed.step_len;
+    result.has_dir = packed.has_dir;
+    return result;
+}
+
+//---------------------------------------------------------------------------//
+// INLINE DEFINITIONS
+//---------------------------------------------------------------------------//
+/*!
+ * Append a scored step.
+ *
+ * Steps outside the position range are still written, with their positions
+ * clamped, and counted so that \c Close can warn about them.
+ */
+void StepRecordWriter::Write(std::size_t sd, int pdg, StepRecord const& rec)
+{
+    CELER_EXPECT(fd_ >= 0);
+    if (CELER_UNLIKELY(pos_ == chunk_records_))
+    {
+        this->Remap();
+    }
+    if (CELER_UNLIKELY(!is_packable(rec)))
+    {
+        ++num_clamped_;
+    }
+    chunk_[pos_++] = pack_step(num_events_, sd, pdg, rec);
+}
@@ -0,0 +1,30 @@
+//------------------------------- -*- C++ -*- -------------------------------//
+// Copyright Celeritas contributors: see top-level COPYRIGHT file for details
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+//---------------------------------------------------------------------------//
+//! \file celer-geant/src/SteppingAction.cc
+//---------------------------------------------------------------------------//
+#include "SteppingAction.hh"
+
+#include <G4Step.hh>
+#include <G4SystemOfUnits.hh>
+#include <corecel/Assert.hh>
+
+#include "RootIO.hh"
+
+//---------------------------------------------------------------------------//
+/*!
+ * Score a step in every mesh.
+ */
+void SteppingAction::UserSteppingAction(G4Step const* step)
+{
+    CELER_EXPECT(step);
+    auto to_array = [](G4ThreeVector const& v) {
+        return ScoringMesh::Real3{v.x() / cm, v.y() / cm, v.z() / cm};
+    };
+    RootIO::Instance()->Data().ScoreMeshes(
+        to_array(step->GetPreStepPoint()->GetPosition()),
+        to_array(step->GetPostStepPoint()->GetPosition()),
+        step->GetTotalEnergyDeposit() / MeV,
+        step->GetStepLength() / cm);
+}
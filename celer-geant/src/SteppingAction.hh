@@ -0,0 +1,23 @@
+//------------------------------- -*- C++ -*- -------------------------------//
+// Copyright Celeritas contributors: see top-level COPYRIGHT file for details
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+//---------------------------------------------------------------------------//
+//! \file celer-geant/src/SteppingAction.hh
+//---------------------------------------------------------------------------//
+#pragma once
+
+#include <G4UserSteppingAction.hh>
+
+//---------------------------------------------------------------------------//
+/*!
+ * Score Geant4 steps in the scoring meshes.
+ *
+ * This is only registered when \c "scoring_meshes" are declared. Steps
+ * tracked by Celeritas are scored by the \c BatchedStepScorer instead.
+ */
+class SteppingAction final : public G4UserSteppingAction
+{
+  public:
+    // Score a step in every mesh
+    void UserSteppingAction(G4Step const* step) final;
+};
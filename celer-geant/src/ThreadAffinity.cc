@@ -0,0 +1,242 @@
+//------------------------------- -*- C++ -*- -------------------------------//
+// Copyright Celeritas contributors: see top-level COPYRIGHT file for details
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+//---------------------------------------------------------------------------//
+//! \file celer-geant/src/ThreadAffinity.cc
+//---------------------------------------------------------------------------//
+#include "ThreadAffinity.hh"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <corecel/Assert.hh>
+#include <corecel/io/Logger.hh>
+
+#ifdef __linux__
+#    include <pthread.h>
+#    include <sched.h>
+#endif
+
+namespace
+{
+//---------------------------------------------------------------------------//
+/*!
+ * Parse a Linux CPU list such as "0-3,8,10-11".
+ */
+ThreadAffinity::VecInt parse_cpu_list(std::string const& text)
+{
+    ThreadAffinity::VecInt result;
+    std::istringstream is(text);
+    std::string range;
+    while (std::getline(is, range, ','))
+    {
+        if (range.empty() || range == "\n")
+        {
+            continue;
+        }
+        auto const dash = range.find('-');
+        int const first = std::stoi(range.substr(0, dash));
+        int const last = dash == std::string::npos
+                             ? first
+                             : std::stoi(range.substr(dash + 1));
+        for (int cpu = first; cpu <= last; ++cpu)
+        {
+            result.push_back(cpu);
+        }
+    }
+    return result;
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * CPUs the process may run on, in increasing order.
+ */
+ThreadAffinity::VecInt allowed_cpus()
+{
+    ThreadAffinity::VecInt result;
+#ifdef __linux__
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    if (sched_getaffinity(0, sizeof(mask), &mask) == 0)
+    {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+        {
+            if (CPU_ISSET(cpu, &mask))
+            {
+                result.push_back(cpu);
+            }
+        }
+    }
+#endif
+    return result;
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * NUMA node of every CPU, or an empty map if the topology is unavailable.
+ */
+std::map<int, int> cpu_nodes()
+{
+    namespace fs = std::filesystem;
+
+    std::map<int, int> result;
+    std::error_code ec;
+    fs::directory_iterator iter("/sys/devices/system/node", ec);
+    if (ec)
+    {
+        return result;
+    }
+    for (auto const& entry : iter)
+    {
+        auto const name = entry.path().filename().string();
+        if (name.compare(0, 4, "node") != 0
+            || name.find_first_not_of("0123456789", 4) != std::string::npos)
+        {
+            continue;
+        }
+        int const node = std::stoi(name.substr(4));
+        std::ifstream is(entry.path() / "cpulist");
+        std::string text;
+        std::getline(is, text);
+        for (int cpu : parse_cpu_list(text))
+        {
+            result[cpu] = node;
+        }
+    }
+    return result;
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Order the allowed CPUs by NUMA node for a compact or scatter policy.
+ */
+ThreadAffinity::VecInt
+order_cpus(ThreadAffinity::VecInt const& cpus, bool scatter)
+{
+    auto const nodes = cpu_nodes();
+    std::map<int, ThreadAffinity::VecInt> by_node;
+    for (int cpu : cpus)
+    {
+        auto iter = nodes.find(cpu);
+        by_node[iter != nodes.end() ? iter->second : 0].push_back(cpu);
+    }
+
+    ThreadAffinity::VecInt result;
+    if (!scatter)
+    {
+        for (auto const& [node, node_cpus] : by_node)
+        {
+            result.insert(result.end(), node_cpus.begin(), node_cpus.end());
+        }
+        return result;
+    }
+
+    // Take the i-th CPU of every node in turn
+    for (size_t i = 0; result.size() < cpus.size(); ++i)
+    {
+        for (auto const& [node, node_cpus] : by_node)
+        {
+            if (i < node_cpus.size())
+            {
+                result.push_back(node_cpus[i]);
+            }
+        }
+    }
+    CELER_LOG(debug) << "Scattering worker threads over " << by_node.size()
+                     << " NUMA nodes";
+    return result;
+}
+
+//---------------------------------------------------------------------------//
+}  // namespace
+
+//---------------------------------------------------------------------------//
+/*!
+ * Construct from the \c "affinity" JSON input.
+ *
+ * This must be called on the master thread, before worker threads change
+ * their affinity.
+ */
+ThreadAffinity::ThreadAffinity(nlohmann::json const& input)
+{
+    if (input.is_string() && input.get<std::string>() == "none")
+    {
+        return;
+    }
+
+    auto const allowed = allowed_cpus();
+    CELER_VALIDATE(!allowed.empty(),
+                   << "thread affinity is not supported on this platform");
+
+    if (input.is_array())
+    {
+        policy_ = Policy::list;
+        cpus_ = input.get<VecInt>();
+        CELER_VALIDATE(!cpus_.empty(), << "\"affinity\" CPU list is empty");
+        for (int cpu : cpus_)
+        {
+            CELER_VALIDATE(
+                std::binary_search(allowed.begin(), allowed.end(), cpu),
+                << "\"affinity\" CPU " << cpu
+                << " is not available to this process");
+        }
+    }
+    else
+    {
+        auto const name = input.get<std::string>();
+        CELER_VALIDATE(name == "compact" || name == "scatter",
+                       << "unknown thread affinity '" << name
+                       << "' (expected \"compact\", \"scatter\", or a list "
+                          "of CPUs)");
+        policy_ = name == "compact" ? Policy::compact : Policy::scatter;
+        cpus_ = order_cpus(allowed, policy_ == Policy::scatter);
+    }
+
+    CELER_LOG(info) << "Pinning worker threads with '" << to_cstring(policy_)
+                    << "' affinity over " << cpus_.size() << " CPUs";
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Pin the calling thread to the CPU of a worker.
+ *
+ * Failing to pin is not fatal: the thread keeps running unpinned.
+ */
+void ThreadAffinity::Apply(int thread_id) const
+{
+    if (!this->enabled())
+    {
+        return;
+    }
+    CELER_EXPECT(thread_id >= 0 && !cpus_.empty());
+    int const cpu = cpus_[static_cast<size_t>(thread_id) % cpus_.size()];
+
+#ifdef __linux__
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    CPU_SET(cpu, &mask);
+    if (int err = pthread_setaffinity_np(pthread_self(), sizeof(mask), &mask))
+    {
+        CELER_LOG_LOCAL(warning)
+            << "Failed to pin thread to CPU " << cpu << " (error " << err
+            << ")";
+        return;
+    }
+    CELER_LOG_LOCAL(debug) << "Pinned thread to CPU " << cpu;
+#else
+    CELER_LOG_LOCAL(warning) << "Cannot pin thread to CPU " << cpu
+                             << " on this platform";
+#endif
+}
+
+//---------------------------------------------------------------------------//
+/*!
+ * Name of an affinity policy.
+ */
+char const* to_cstring(ThreadAffinity::Policy policy)
+{
+    static char const* const names[] = {"none", "compact", "scatter", "list"};
+    return names[static_cast<size_t>(policy)];
+}
@@ -0,0 +1,73 @@
+//------------------------------- -*- C++ -*- -------------------------------//
+// Copyright Celeritas contributors: see top-level COPYRIGHT file for details
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+//---------------------------------------------------------------------------//
+//! \file celer-geant/src/ThreadAffinity.hh
+//---------------------------------------------------------------------------//
+#pragma once
+
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+//---------------------------------------------------------------------------//
+/*!
+ * CPU affinity of worker threads.
+ *
+ * The optional \c "affinity" JSON input pins every worker thread to a single
+ * CPU when it starts:
+ * - \c "compact" : fill the CPUs of one NUMA node before the next.
+ * - \c "scatter" : alternate between NUMA nodes, so that workers are spread
+ *   evenly over the sockets.
+ * - \c [0, 2, 4, ...] : explicit CPU of each worker.
+ *
+ * Workers with an ID beyond the number of CPUs wrap around. The CPU order is
+ * computed once on the master thread, from the CPUs the process may run on
+ * and the NUMA nodes in \c /sys/devices/system/node .
+ *
+ * Pinning happens in \c WorkerInitialization::WorkerInitialize , before the
+ * thread builds its user actions, sensitive detectors, \c RootIO data store,
+ * and Celeritas state. Pages of those allocations are then first touched by
+ * a thread that stays on its NUMA node, so that Linux places them in local
+ * memory.
+ */
+class ThreadAffinity
+{
+  public:
+    enum class Policy
+    {
+        none,
+        compact,
+        scatter,
+        list
+    };
+
+    using VecInt = std::vector<int>;
+
+  public:
+    //! Construct without pinning
+    ThreadAffinity() = default;
+
+    // Construct from the "affinity" JSON input
+    explicit ThreadAffinity(nlohmann::json const& input);
+
+    // Pin the calling thread to the CPU of a worker
+    void Apply(int thread_id) const;
+
+    //! Whether threads are pinned
+    bool enabled() const { return policy_ != Policy::none; }
+
+    //! Selected policy
+    Policy policy() const { return policy_; }
+
+    //! CPU of each worker ID, in order
+    VecInt const& cpus() const { return cpus_; }
+
+  private:
+    Policy policy_{Policy::none};
+    VecInt cpus_;
+};
+
+//---------------------------------------------------------------------------//
+// Name of an affinity policy
+char const* to_cstring(ThreadAffinity::Policy policy);
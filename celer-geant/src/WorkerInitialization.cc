@@ -0,0 +1,20 @@
+//------------------------------- -*- C++ -*- -------------------------------//
+// Copyright Celeritas contributors: see top-level COPYRIGHT file for details
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+//---------------------------------------------------------------------------//
+//! \file celer-geant/src/WorkerInitialization.cc
+//---------------------------------------------------------------------------//
+#include "WorkerInitialization.hh"
+
+#include <G4Threading.hh>
+
+#include "Config.hh"
+
+//---------------------------------------------------------------------------//
+/*!
+ * Pin the worker thread to its CPU.
+ */
+void WorkerInitialization::WorkerInitialize() const
+{
+    Config::Instance().affinity.Apply(G4Threading::G4GetThreadId());
+}
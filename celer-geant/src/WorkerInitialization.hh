@@ -0,0 +1,27 @@
+//------------------------------- -*- C++ -*- -------------------------------//
+// Copyright Celeritas contributors: see top-level COPYRIGHT file for details
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+//---------------------------------------------------------------------------//
+//! \file celer-geant/src/WorkerInitialization.hh
+//---------------------------------------------------------------------------//
+#pragma once
+
+#include <G4UserWorkerInitialization.hh>
+
+//---------------------------------------------------------------------------//
+/*!
+ * Prepare worker threads before they build their geometry and actions.
+ *
+ * Geant4 calls \c WorkerInitialize first thing in every new worker thread,
+ * so the thread is pinned (see \c ThreadAffinity ) before any thread-local
+ * data is allocated.
+ */
+class WorkerInitialization final : public G4UserWorkerInitialization
+{
+  public:
+    //! Construct empty
+    WorkerInitialization() = default;
+
+    //! Pin the worker thread to its CPU
+    void WorkerInitialize() const final;
+};